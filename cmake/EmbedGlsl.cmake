@@ -0,0 +1,20 @@
+# Turns a GLSL source into a C++ header with the source text as a raw string literal.
+#
+# cmake -DSOURCE=<glsl source> -DHEADER=<output header> -DIDENTIFIER=<c identifier> -P EmbedGlsl.cmake
+
+get_filename_component(sourceName ${SOURCE} NAME)
+
+file(READ ${SOURCE} source)
+
+if (source MATCHES "\\)glsl\"")
+    message(FATAL_ERROR "${sourceName} contains the raw string delimiter )glsl\"")
+endif ()
+
+string(TOUPPER "${IDENTIFIER}_HPP" guard)
+
+set(header "// Generated by EmbedGlsl.cmake from ${sourceName}, do not edit.\n\n")
+string(APPEND header "#ifndef ${guard}\n#define ${guard}\n\n")
+string(APPEND header "static const char *${IDENTIFIER} = R\"glsl(${source})glsl\";\n\n")
+string(APPEND header "#endif // ${guard}\n")
+
+file(WRITE ${HEADER} "${header}")
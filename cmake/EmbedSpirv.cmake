@@ -0,0 +1,84 @@
+# Turns a SPIR-V binary into a C++ header with the code as a byte array and a SpirvModule that
+# carries the reflection the GL needs, because SPIR-V programs can not look uniforms up by name.
+#
+# cmake -DSOURCE=<glsl source> -DSPIRV=<spv file> -DHEADER=<output header> -DIDENTIFIER=<c identifier> -P EmbedSpirv.cmake
+
+get_filename_component(sourceName ${SOURCE} NAME)
+get_filename_component(extension ${SOURCE} LAST_EXT)
+
+if (extension STREQUAL ".vert")
+    set(stage GL_VERTEX_SHADER)
+elseif (extension STREQUAL ".frag")
+    set(stage GL_FRAGMENT_SHADER)
+elseif (extension STREQUAL ".comp")
+    set(stage GL_COMPUTE_SHADER)
+elseif (extension STREQUAL ".geom")
+    set(stage GL_GEOMETRY_SHADER)
+elseif (extension STREQUAL ".tesc")
+    set(stage GL_TESS_CONTROL_SHADER)
+elseif (extension STREQUAL ".tese")
+    set(stage GL_TESS_EVALUATION_SHADER)
+else ()
+    message(FATAL_ERROR "unknown shader stage for ${sourceName}")
+endif ()
+
+file(READ ${SPIRV} code HEX)
+string(REGEX REPLACE "(..)" "0x\\1," code "${code}")
+string(REGEX REPLACE "(0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,)" "\\1\n    " code "${code}")
+
+file(READ ${SOURCE} source)
+
+# layout(location = N) uniform <type> <name>;
+string(REGEX MATCHALL "layout[ \t]*\\([ \t]*location[ \t]*=[ \t]*[0-9]+[^)]*\\)[ \t\r\n]*uniform[ \t\r\n]+[A-Za-z0-9_]+[ \t\r\n]+[A-Za-z0-9_]+" uniforms "${source}")
+set(uniformCount 0)
+set(uniformEntries "")
+foreach (uniform ${uniforms})
+    string(REGEX REPLACE ".*location[ \t]*=[ \t]*([0-9]+).*" "\\1" location "${uniform}")
+    string(REGEX REPLACE ".*[ \t\r\n]([A-Za-z0-9_]+)$" "\\1" name "${uniform}")
+    string(APPEND uniformEntries "    {\"${name}\", ${location}},\n")
+    math(EXPR uniformCount "${uniformCount} + 1")
+endforeach ()
+
+# layout(constant_id = N) const <type> <name> = <default>;
+string(REGEX MATCHALL "layout[ \t]*\\([ \t]*constant_id[ \t]*=[ \t]*[0-9]+[ \t]*\\)[ \t\r\n]*const[ \t\r\n]+[A-Za-z0-9_]+[ \t\r\n]+[A-Za-z0-9_]+" constants "${source}")
+set(constantCount 0)
+set(constantEntries "")
+foreach (constant ${constants})
+    string(REGEX REPLACE ".*constant_id[ \t]*=[ \t]*([0-9]+).*" "\\1" id "${constant}")
+    string(REGEX REPLACE ".*[ \t\r\n]([A-Za-z0-9_]+)$" "\\1" name "${constant}")
+    string(APPEND constantEntries "    {\"${name}\", ${id}},\n")
+    math(EXPR constantCount "${constantCount} + 1")
+endforeach ()
+
+string(TOUPPER "${IDENTIFIER}_HPP" guard)
+
+set(header "// Generated by EmbedSpirv.cmake from ${sourceName}, do not edit.\n\n")
+string(APPEND header "#ifndef ${guard}\n#define ${guard}\n\n#include <shader.hpp>\n\n")
+string(APPEND header "alignas(4) static const unsigned char ${IDENTIFIER}_code[] = {\n    ${code}\n};\n\n")
+
+if (uniformCount GREATER 0)
+    string(APPEND header "static const SpirvUniform ${IDENTIFIER}_uniforms[] = {\n${uniformEntries}};\n\n")
+    set(uniformsRef "${IDENTIFIER}_uniforms")
+else ()
+    set(uniformsRef "nullptr")
+endif ()
+
+if (constantCount GREATER 0)
+    string(APPEND header "static const SpirvSpecConstant ${IDENTIFIER}_constants[] = {\n${constantEntries}};\n\n")
+    set(constantsRef "${IDENTIFIER}_constants")
+else ()
+    set(constantsRef "nullptr")
+endif ()
+
+string(APPEND header "static const SpirvModule ${IDENTIFIER} = {\n")
+string(APPEND header "    ${stage},\n")
+string(APPEND header "    ${IDENTIFIER}_code,\n")
+string(APPEND header "    sizeof(${IDENTIFIER}_code),\n")
+string(APPEND header "    \"main\",\n")
+string(APPEND header "    ${uniformsRef},\n")
+string(APPEND header "    ${uniformCount},\n")
+string(APPEND header "    ${constantsRef},\n")
+string(APPEND header "    ${constantCount},\n")
+string(APPEND header "};\n\n#endif // ${guard}\n")
+
+file(WRITE ${HEADER} "${header}")
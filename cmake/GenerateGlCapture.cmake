@@ -0,0 +1,406 @@
+# Generates both ends of GL capture from glad.h: the shims GlCapture installs over the glad function
+# table, which forward every call and then write it with the data it passed to the capture, and the
+# functions playground-replay reads those records back with and re-issues them.
+#
+# Every parameter is classified once and both ends are generated from that, so they always agree on
+# the format. Scalars are written as they are. Pointers are written with a tag: inline data for
+# memory of a known size (buffer data, pixels, shader sources, uniform arrays, name lists), the
+# value for buffer offsets (indices, indirect commands, vertex attributes), a placeholder for
+# outputs, or unsupported for memory of unknown size, which the replay skips. Object names, syncs,
+# uniform locations and mapped pointers are remapped by the replay to the ones its context hands out.
+#
+# cmake -DGLAD_HEADER=<glad.h> -DCAPTURE_OUTPUT=<.cpp> -DREPLAY_OUTPUT=<.cpp> -P GenerateGlCapture.cmake
+
+# Scripts run with -P start out with old policies, IN_LIST needs CMP0057
+cmake_policy(VERSION 3.20)
+
+include(${CMAKE_CURRENT_LIST_DIR}/GladFunctions.cmake)
+
+read_glad_functions(${GLAD_HEADER})
+
+# Parameters that make a call impossible to replay, these calls are forwarded but not captured
+set(unsupportedTypes "GLDEBUGPROC|GLVULKANPROCNV|GLeglImageOES|GLeglClientBufferEXT|struct _cl_")
+
+# Scalar parameters that hold the element count of the arrays a call passes, in order of preference
+set(countNames n count drawcount numAttachments numSpecializationConstants uniformCount)
+
+# The namespace of an object name parameter, empty for parameters that are not object names
+function(object_namespace function name result)
+    set(namespace "")
+
+    if (name MATCHES "^(buffers?|readBuffer|writeBuffer)$")
+        set(namespace GlNameBuffer)
+    elseif (name MATCHES "^(textures?|origtexture)$")
+        set(namespace GlNameTexture)
+    elseif (name MATCHES "^(framebuffers?|readFramebuffer|drawFramebuffer)$")
+        set(namespace GlNameFramebuffer)
+    elseif (name MATCHES "^renderbuffers?$")
+        set(namespace GlNameRenderbuffer)
+    elseif (name MATCHES "^(arrays?|vaobj)$")
+        set(namespace GlNameVertexArray)
+    elseif (name MATCHES "^samplers?$")
+        set(namespace GlNameSampler)
+    elseif (name MATCHES "^pipelines?$")
+        set(namespace GlNameProgramPipeline)
+    elseif (name MATCHES "^(programs?|shaders?)$")
+        set(namespace GlNameProgram)
+    elseif (name MATCHES "^(id|ids|xfb)$" AND function MATCHES "TransformFeedback")
+        set(namespace GlNameTransformFeedback)
+    elseif (name MATCHES "^(id|ids)$" AND function MATCHES "Quer")
+        set(namespace GlNameQuery)
+    endif ()
+
+    set(${result} "${namespace}" PARENT_SCOPE)
+endfunction()
+
+# Sets captureCode, the statement that writes the parameter, and replayRead, replayArgument and
+# replayPost, the statement that reads it back, the argument to call with and what to do after
+function(classify_parameter function type name scalars hasProgram)
+    set(captureCode "")
+    set(replayRead "")
+    set(replayArgument "a_${name}")
+    set(replayPost "")
+
+    string(REGEX REPLACE "const|\\*| " "" baseType "${type}")
+
+    set(countName "")
+
+    foreach (candidate ${countNames})
+        if (candidate IN_LIST scalars)
+            set(countName ${candidate})
+            break()
+        endif ()
+    endforeach ()
+
+    object_namespace(${function} ${name} namespace)
+
+    if (NOT type MATCHES "\\*")
+        if (type STREQUAL "GLsync")
+            set(captureCode "record_.sync(${name});")
+            set(replayRead "auto a_${name} = replay_.sync();")
+        elseif (type STREQUAL "GLuint" AND namespace)
+            set(captureCode "record_.value(${name});")
+            set(replayRead "auto a_${name} = replay_.name(${namespace}, replay_.value<GLuint>());")
+        elseif (type STREQUAL "GLint" AND name STREQUAL "location" AND function MATCHES "Uniform")
+            set(program "replay_.currentProgram()")
+
+            if (hasProgram)
+                set(program "a_program")
+            endif ()
+
+            set(captureCode "record_.value(${name});")
+            set(replayRead "auto a_${name} = replay_.location(${program}, replay_.value<GLint>());")
+        else ()
+            set(captureCode "record_.value(${name});")
+            set(replayRead "auto a_${name} = replay_.value<${type}>();")
+        endif ()
+    else ()
+        set(replayRead "auto a_${name} = static_cast<${type}>(replay_.pointer());")
+
+        if (NOT type MATCHES "^const")
+            if (function MATCHES "^gl(Gen|Create)[A-Z]" AND type STREQUAL "GLuint *" AND namespace)
+                # New object names, the replay maps the captured ones to the ones it gets
+                set(captureCode "record_.data(${name}, ${countName} * sizeof(GLuint));")
+                set(replayRead "auto a_${name}_captured = static_cast<const GLuint *>(replay_.pointer());\n    std::vector<GLuint> a_${name}(a_${countName});")
+                set(replayArgument "a_${name}.data()")
+                set(replayPost "replay_.mapNames(${namespace}, a_${name}_captured, a_${name}.data(), a_${countName});")
+            elseif (function MATCHES "^glReadn?Pixels$")
+                set(captureCode "record_.packPixels(${name}, format, type, width, height);")
+            elseif (function MATCHES "^glGetn?(Compressed)?Tex(ture)?(Sub)?Image$")
+                set(size "0")
+
+                if ("bufSize" IN_LIST scalars)
+                    set(size "bufSize")
+                endif ()
+
+                set(captureCode "record_.packOutput(${name}, ${size});")
+            elseif (function MATCHES "^glGet(Named)?BufferSubData$")
+                set(captureCode "record_.output(${name}, size);")
+            elseif (function MATCHES "^gl(Get|Read|Are|Gen|Create)")
+                set(size "0")
+
+                if ("bufSize" IN_LIST scalars)
+                    set(size "bufSize")
+                elseif (NOT countName STREQUAL "" AND NOT baseType STREQUAL "void")
+                    set(size "${countName} * sizeof(${baseType})")
+                endif ()
+
+                set(captureCode "record_.output(${name}, ${size});")
+            else ()
+                set(captureCode "record_.unsupported();")
+            endif ()
+        elseif (type MATCHES "GLchar \\*const\\*$")
+            set(lengths "nullptr")
+
+            if (function MATCHES "^glShaderSource")
+                set(lengths "length")
+            endif ()
+
+            set(captureCode "record_.strings(${countName}, ${name}, ${lengths});")
+            set(replayRead "auto a_${name} = replay_.strings();")
+        elseif (function MATCHES "^gl(Named)?Buffer(Sub)?Data$|^gl(Named)?BufferStorage$")
+            set(captureCode "record_.data(${name}, size);")
+        elseif (function MATCHES "^glTex(ture)?(Sub)?Image[123]D$")
+            set(height 1)
+            set(depth 1)
+
+            if ("height" IN_LIST scalars)
+                set(height height)
+            endif ()
+
+            if ("depth" IN_LIST scalars)
+                set(depth depth)
+            endif ()
+
+            set(captureCode "record_.pixels(${name}, format, type, width, ${height}, ${depth});")
+        elseif (function MATCHES "^glCompressedTex(ture)?(Sub)?Image[123]D$")
+            set(captureCode "record_.unpackData(${name}, imageSize);")
+        elseif (function MATCHES "^glClear(Named)?Buffer(Sub)?Data$|^glClearTex(Sub)?Image$")
+            set(captureCode "record_.texel(${name}, format, type);")
+        elseif (function MATCHES "^glShaderBinary$|^glProgramBinary$" AND name STREQUAL "binary")
+            set(captureCode "record_.data(${name}, length);")
+        elseif (function MATCHES "^gl(Program)?Uniform([1-4])(f|i|ui|d|i64|ui64)v$")
+            set(captureCode "record_.data(${name}, count * ${CMAKE_MATCH_2} * sizeof(${baseType}));")
+        elseif (function MATCHES "^gl(Program)?UniformMatrix([2-4])x?([2-4]?)(f|d)v$")
+            set(columns ${CMAKE_MATCH_2})
+            set(rows ${CMAKE_MATCH_3})
+
+            if (NOT rows)
+                set(rows ${columns})
+            endif ()
+
+            set(captureCode "record_.data(${name}, count * ${columns} * ${rows} * sizeof(${baseType}));")
+        elseif (function MATCHES "^glVertexAttrib[IL]?([1-4])N?(b|s|i|f|d|ub|us|ui|i64|ui64)v$")
+            set(captureCode "record_.data(${name}, ${CMAKE_MATCH_1} * sizeof(${baseType}));")
+        elseif (function MATCHES "^gl(Tex|Texture|Sampler)ParameterI?(f|i|ui|iu)v$")
+            set(captureCode "record_.data(${name}, GlCaptureRecord::parameterCount(pname) * sizeof(${baseType}));")
+        elseif (function STREQUAL "glPatchParameterfv")
+            set(captureCode "record_.data(${name}, (pname == GL_PATCH_DEFAULT_INNER_LEVEL ? 2 : 4) * sizeof(${baseType}));")
+        elseif (function MATCHES "^glClearBuffer(iv|uiv|fv)$|^glClearNamedFramebuffer(iv|uiv|fv)$")
+            set(captureCode "record_.data(${name}, (buffer == GL_COLOR ? 4 : 1) * sizeof(${baseType}));")
+        elseif (function MATCHES "^gl(Viewport|Scissor)Arrayv$")
+            set(captureCode "record_.data(${name}, count * 4 * sizeof(${baseType}));")
+        elseif (function MATCHES "^gl(ScissorIndexed|ViewportIndexedf)v$")
+            set(captureCode "record_.data(${name}, 4 * sizeof(${baseType}));")
+        elseif (function MATCHES "^glPointParameter(f|i)v$|^glVertexAttribP[1-4]uiv$")
+            set(captureCode "record_.data(${name}, sizeof(${baseType}));")
+        elseif (function MATCHES "^glDepthRangeArrayv$")
+            set(captureCode "record_.data(${name}, count * 2 * sizeof(${baseType}));")
+        elseif (type MATCHES "^const GLchar \\*$")
+            set(length "-1")
+
+            if ("length" IN_LIST scalars)
+                set(length "length")
+            endif ()
+
+            set(captureCode "record_.string(${name}, ${length});")
+        elseif (type MATCHES "^const void \\*const\\*$" AND NOT countName STREQUAL "")
+            # Arrays of offsets into the bound buffers
+            set(captureCode "record_.data(${name}, ${countName} * sizeof(const void *));")
+        elseif (NOT countName STREQUAL "" AND NOT baseType MATCHES "^(void|GLchar)$")
+            set(captureCode "record_.data(${name}, ${countName} * sizeof(${baseType}));")
+
+            if (type MATCHES "GLuint" AND namespace)
+                set(replayRead "auto a_${name} = replay_.names(${namespace});")
+            endif ()
+        elseif (baseType STREQUAL "void" AND (name MATCHES "^(indices|indirect|pointer|offset)$" OR function MATCHES "Draw"))
+            set(captureCode "record_.offset(${name});")
+        else ()
+            set(captureCode "record_.unsupported();")
+        endif ()
+    endif ()
+
+    set(captureCode "${captureCode}" PARENT_SCOPE)
+    set(replayRead "${replayRead}" PARENT_SCOPE)
+    set(replayArgument "${replayArgument}" PARENT_SCOPE)
+    set(replayPost "${replayPost}" PARENT_SCOPE)
+endfunction()
+
+set(shims "")
+set(installs "")
+set(removes "")
+set(replays "")
+set(replayTable "")
+set(captureNames "")
+set(index 0)
+
+foreach (function type returnType parameters arguments IN ZIP_LISTS gladNames gladTypes gladReturnTypes gladParameters gladArguments)
+    if (arguments STREQUAL "-")
+        set(arguments "")
+    endif ()
+
+    if (parameters MATCHES "${unsupportedTypes}")
+        continue()
+    endif ()
+
+    set(parameterList "")
+    set(scalars "")
+    set(names "")
+    set(types "")
+
+    if (NOT parameters STREQUAL "void")
+        string(REPLACE "," ";" parameterList "${parameters}")
+    endif ()
+
+    foreach (parameter ${parameterList})
+        string(STRIP "${parameter}" parameter)
+        string(REGEX MATCH "[A-Za-z_][A-Za-z0-9_]*$" name "${parameter}")
+        string(REGEX REPLACE "[A-Za-z_][A-Za-z0-9_]*$" "" parameterType "${parameter}")
+        string(STRIP "${parameterType}" parameterType)
+
+        list(APPEND names ${name})
+        list(APPEND types "${parameterType}")
+
+        if (NOT parameterType MATCHES "\\*")
+            list(APPEND scalars ${name})
+        endif ()
+    endforeach ()
+
+    set(hasProgram FALSE)
+
+    if ("program" IN_LIST scalars)
+        set(hasProgram TRUE)
+    endif ()
+
+    set(captures "")
+    set(reads "")
+    set(callArguments "")
+    set(posts "")
+
+    foreach (name parameterType IN ZIP_LISTS names types)
+        classify_parameter(${function} "${parameterType}" ${name} "${scalars}" ${hasProgram})
+
+        string(APPEND captures "        ${captureCode}\n")
+        string(APPEND reads "    ${replayRead}\n")
+        list(APPEND callArguments "${replayArgument}")
+
+        if (replayPost)
+            string(APPEND posts "    ${replayPost}\n")
+        endif ()
+    endforeach ()
+
+    string(REPLACE ";" ", " callArguments "${callArguments}")
+
+    # Hooks that follow what the app writes to mapped buffers
+    set(before "")
+    set(after "")
+
+    if (function STREQUAL "glMapBufferRange")
+        set(after "    glCapture().mapped(target, result_, length, (access & GL_MAP_WRITE_BIT) != 0);\n")
+    elseif (function STREQUAL "glMapNamedBufferRange")
+        set(after "    glCapture().mapped(GlCapture::namedKey(buffer), result_, length, (access & GL_MAP_WRITE_BIT) != 0);\n")
+    elseif (function STREQUAL "glMapBuffer")
+        set(after "    glCapture().mapped(target, result_, glCapture().bufferSize(target), access != GL_READ_ONLY);\n")
+    elseif (function STREQUAL "glMapNamedBuffer")
+        set(after "    glCapture().mapped(GlCapture::namedKey(buffer), result_, glCapture().namedBufferSize(buffer), access != GL_READ_ONLY);\n")
+    elseif (function STREQUAL "glFlushMappedBufferRange")
+        set(before "    glCapture().flushMapped(target, offset, length);\n\n")
+    elseif (function STREQUAL "glFlushMappedNamedBufferRange")
+        set(before "    glCapture().flushMapped(GlCapture::namedKey(buffer), offset, length);\n\n")
+    elseif (function STREQUAL "glUnmapBuffer")
+        set(before "    glCapture().unmapping(target);\n\n")
+    elseif (function STREQUAL "glUnmapNamedBuffer")
+        set(before "    glCapture().unmapping(GlCapture::namedKey(buffer));\n\n")
+    endif ()
+
+    # What the call returns is written after the parameters, names, syncs, locations and mapped
+    # pointers are remapped by the replay
+    set(captureReturn "")
+    set(readReturn "")
+    set(replayCall "glad_${function}(${callArguments});")
+
+    if (NOT returnType STREQUAL "void")
+        set(replayCall "auto result_ = glad_${function}(${callArguments});")
+
+        if (returnType MATCHES "\\*" OR returnType STREQUAL "GLsync")
+            set(captureReturn "        record_.value(reinterpret_cast<uint64_t>(result_));\n")
+            set(readReturn "    auto a_captured = replay_.value<uint64_t>();\n")
+        else ()
+            set(captureReturn "        record_.value(result_);\n")
+            set(readReturn "    auto a_captured = replay_.value<${returnType}>();\n")
+        endif ()
+
+        if (function MATCHES "^glCreate(Shader|Program|ShaderProgramv)$")
+            string(APPEND posts "    replay_.mapName(GlNameProgram, a_captured, result_);\n")
+        elseif (function STREQUAL "glFenceSync")
+            string(APPEND posts "    replay_.mapSync(a_captured, result_);\n")
+        elseif (function STREQUAL "glGetUniformLocation")
+            string(APPEND posts "    replay_.mapLocation(a_program, a_captured, result_);\n")
+        elseif (function MATCHES "^glMap(Named)?Buffer(Range)?$")
+            string(APPEND posts "    replay_.mapPointer(a_captured, result_);\n")
+        else ()
+            string(APPEND posts "    (void)a_captured;\n    (void)result_;\n")
+        endif ()
+    endif ()
+
+    if (function STREQUAL "glUseProgram")
+        string(APPEND posts "    replay_.useProgram(a_program);\n")
+    endif ()
+
+    if (function STREQUAL "glDeleteSync")
+        string(APPEND posts "    replay_.deleteSync(a_sync);\n")
+    endif ()
+
+    # The shim
+    string(APPEND shims "static ${type} real_${function} = nullptr;\n\n")
+    string(APPEND shims "static ${returnType} APIENTRY capture_${function}(${parameters})\n{\n${before}")
+
+    if (returnType STREQUAL "void")
+        string(APPEND shims "    real_${function}(${arguments});\n\n")
+    else ()
+        string(APPEND shims "    auto result_ = real_${function}(${arguments});\n\n")
+    endif ()
+
+    string(APPEND shims "    if (GlCaptureRecord record_(${index}); record_)\n    {\n${captures}${captureReturn}    }\n")
+
+    if (after)
+        string(APPEND shims "\n${after}")
+    endif ()
+
+    if (NOT returnType STREQUAL "void")
+        string(APPEND shims "\n    return result_;\n")
+    endif ()
+
+    string(APPEND shims "}\n\n")
+
+    string(APPEND installs "    if (glad_${function} != nullptr && glad_${function} != capture_${function})\n    {\n")
+    string(APPEND installs "        real_${function} = glad_${function};\n        glad_${function} = capture_${function};\n    }\n\n")
+
+    string(APPEND removes "    if (glad_${function} == capture_${function})\n    {\n        glad_${function} = real_${function};\n    }\n\n")
+
+    string(APPEND captureNames "    \"${function}\",\n")
+
+    # The replay
+    string(APPEND replays "static void replay_${function}(\n    GlReplay &replay_)\n{\n${reads}${readReturn}\n")
+    string(APPEND replays "    if (!replay_.callable() || glad_${function} == nullptr)\n    {\n        replay_.skip();\n\n        return;\n    }\n\n")
+    string(APPEND replays "    ${replayCall}\n")
+
+    if (posts)
+        string(APPEND replays "\n${posts}")
+    endif ()
+
+    string(APPEND replays "}\n\n")
+
+    string(APPEND replayTable "    {\"${function}\", replay_${function}},\n")
+
+    math(EXPR index "${index} + 1")
+endforeach ()
+
+get_filename_component(headerName ${GLAD_HEADER} NAME)
+
+set(capture "// Generated by GenerateGlCapture.cmake from ${headerName}, do not edit.\n\n")
+string(APPEND capture "#include \"glcaptureshims.hpp\"\n\n")
+string(APPEND capture "${shims}")
+string(APPEND capture "const char *const glCaptureFunctionNames[] = {\n${captureNames}};\n\n")
+string(APPEND capture "const int glCaptureFunctionCount = ${index};\n\n")
+string(APPEND capture "void installGlCaptureShims()\n{\n${installs}}\n\n")
+string(APPEND capture "void removeGlCaptureShims()\n{\n${removes}}\n")
+
+set(replay "// Generated by GenerateGlCapture.cmake from ${headerName}, do not edit.\n\n")
+string(APPEND replay "#include \"glreplay.hpp\"\n\n#include <vector>\n\n")
+string(APPEND replay "${replays}")
+string(APPEND replay "const GlReplayFunction glReplayFunctions[] = {\n${replayTable}};\n\n")
+string(APPEND replay "const int glReplayFunctionCount = ${index};\n")
+
+file(WRITE ${CAPTURE_OUTPUT} "${capture}")
+file(WRITE ${REPLAY_OUTPUT} "${replay}")
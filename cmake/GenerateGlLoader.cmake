@@ -0,0 +1,90 @@
+# Generates a lazy GL loader from glad.h. Instead of resolving every entry point up front like
+# gladLoadGLLoader, gladLoadGLLazy points each glad_gl* function pointer at a trampoline that resolves
+# the real function on its first call, replaces the pointer and forwards the call. Only GL_VERSION and
+# the extension list are queried at load time, to set GLVersion and the GLAD_GL_* flags.
+# gladLazyResolveAll resolves what is left, for layers that wrap the function table.
+#
+# cmake -DGLAD_HEADER=<glad.h> -DOUTPUT=<generated .c file> -P GenerateGlLoader.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/GladFunctions.cmake)
+
+read_glad_functions(${GLAD_HEADER})
+file(READ ${GLAD_HEADER} header)
+
+set(trampolines "")
+set(assignments "")
+set(resolves "")
+list(LENGTH gladNames functionCount)
+
+foreach (name type returnType parameters arguments IN ZIP_LISTS gladNames gladTypes gladReturnTypes gladParameters gladArguments)
+    if (arguments STREQUAL "-")
+        set(arguments "")
+    endif ()
+
+    if (returnType STREQUAL "void")
+        set(forward "    glad_${name}(${arguments});\n")
+    else ()
+        set(forward "    return glad_${name}(${arguments});\n")
+    endif ()
+
+    string(APPEND trampolines "static ${returnType} APIENTRY glad_lazy_${name}(${parameters})\n{\n")
+    string(APPEND trampolines "    glad_${name} = (${type})glad_lazy_resolve(\"${name}\");\n${forward}}\n\n")
+    string(APPEND assignments "    glad_${name} = glad_lazy_${name};\n")
+    string(APPEND resolves "    if (glad_${name} == glad_lazy_${name})\n    {\n        glad_${name} = (${type})glad_lazy_resolve(\"${name}\");\n    }\n\n")
+endforeach ()
+
+# GLAPI int GLAD_GL_VERSION_<major>_<minor>; and GLAPI int GLAD_GL_<extension>;
+string(REGEX MATCHALL "GLAPI int GLAD_GL_[A-Za-z0-9_]+" flags "${header}")
+
+set(versions "")
+set(extensionNames "")
+
+foreach (flag ${flags})
+    string(REPLACE "GLAPI int GLAD_" "" flagName "${flag}")
+
+    if (flagName MATCHES "^GL_VERSION_([0-9]+)_([0-9]+)$")
+        string(APPEND versions "    GLAD_${flagName} = major > ${CMAKE_MATCH_1} || (major == ${CMAKE_MATCH_1} && minor >= ${CMAKE_MATCH_2});\n")
+    else ()
+        list(APPEND extensionNames ${flagName})
+    endif ()
+endforeach ()
+
+# Sorted the way strcmp sorts, so extensions can be looked up with bsearch
+list(SORT extensionNames)
+
+set(extensions "")
+
+foreach (extension ${extensionNames})
+    string(APPEND extensions "    {\"${extension}\", &GLAD_${extension}},\n")
+endforeach ()
+
+get_filename_component(headerName ${GLAD_HEADER} NAME)
+
+set(source "// Generated by GenerateGlLoader.cmake from ${headerName}, do not edit.\n\n")
+string(APPEND source "#include <glad/glad.h>\n\n#include <stdlib.h>\n#include <string.h>\n\n")
+string(APPEND source "static GLADloadproc glad_lazy_load = NULL;\nstatic int glad_lazy_resolved = 0;\n\n")
+string(APPEND source "static void *glad_lazy_resolve(const char *name)\n{\n    glad_lazy_resolved++;\n\n    return glad_lazy_load(name);\n}\n\n")
+string(APPEND source "${trampolines}")
+string(APPEND source "typedef struct\n{\n    const char *name;\n    int *flag;\n} glad_lazy_extension;\n\n")
+string(APPEND source "static glad_lazy_extension glad_lazy_extensions[] = {\n${extensions}};\n\n")
+string(APPEND source "static int glad_lazy_compare(const void *name, const void *extension)\n{\n    return strcmp((const char *)name, ((const glad_lazy_extension *)extension)->name);\n}\n\n")
+string(APPEND source "static int glad_lazy_find_version(void)\n{\n")
+string(APPEND source "    const char *version = (const char *)glGetString(GL_VERSION);\n    char *end = NULL;\n    int major, minor;\n\n")
+string(APPEND source "    if (version == NULL)\n    {\n        return 0;\n    }\n\n")
+string(APPEND source "    major = (int)strtol(version, &end, 10);\n    minor = *end == '.' ? (int)strtol(end + 1, NULL, 10) : 0;\n\n")
+string(APPEND source "    GLVersion.major = major;\n    GLVersion.minor = minor;\n\n${versions}\n    return major > 0;\n}\n\n")
+string(APPEND source "static void glad_lazy_find_extensions(void)\n{\n")
+string(APPEND source "    const size_t count = sizeof(glad_lazy_extensions) / sizeof(glad_lazy_extensions[0]);\n    GLint available = 0;\n    GLint i;\n    size_t j;\n\n")
+string(APPEND source "    for (j = 0; j < count; j++)\n    {\n        *glad_lazy_extensions[j].flag = 0;\n    }\n\n")
+string(APPEND source "    glGetIntegerv(GL_NUM_EXTENSIONS, &available);\n\n")
+string(APPEND source "    for (i = 0; i < available; i++)\n    {\n")
+string(APPEND source "        const char *name = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);\n")
+string(APPEND source "        glad_lazy_extension *extension = name != NULL ? (glad_lazy_extension *)bsearch(name, glad_lazy_extensions, count, sizeof(glad_lazy_extension), glad_lazy_compare) : NULL;\n\n")
+string(APPEND source "        if (extension != NULL)\n        {\n            *extension->flag = 1;\n        }\n    }\n}\n\n")
+string(APPEND source "int gladLoadGLLazy(GLADloadproc load)\n{\n    glad_lazy_load = load;\n    glad_lazy_resolved = 0;\n\n${assignments}\n")
+string(APPEND source "    if (!glad_lazy_find_version())\n    {\n        return 0;\n    }\n\n    glad_lazy_find_extensions();\n\n    return 1;\n}\n\n")
+string(APPEND source "void gladLazyResolveAll(void)\n{\n${resolves}}\n\n")
+string(APPEND source "int gladLazyResolvedCount(void)\n{\n    return glad_lazy_resolved;\n}\n\n")
+string(APPEND source "int gladLazyFunctionCount(void)\n{\n    return ${functionCount};\n}\n")
+
+file(WRITE ${OUTPUT} "${source}")
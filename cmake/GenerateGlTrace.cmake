@@ -0,0 +1,104 @@
+# Generates the shims GlTrace installs over the glad function table. Every shim counts its call and
+# forwards it to the function the table pointed at before. Functions are classified by name as draw
+# (draws, dispatches, clears and blits), state change (binds, enables, uniforms and fixed function
+# state) or upload (buffer and texture data, mapping and copies), the rest is other.
+#
+# cmake -DGLAD_HEADER=<glad.h> -DOUTPUT=<generated .cpp file> -P GenerateGlTrace.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/GladFunctions.cmake)
+
+read_glad_functions(${GLAD_HEADER})
+
+set(drawPatterns
+    "^gl(Multi)?Draw(Arrays|Elements|RangeElements|TransformFeedback|MeshTasks)"
+    "^glDispatchCompute"
+    "^glClear$"
+    "^glClearBuffer[a-z]+$"
+    "^glClearNamedFramebuffer"
+    "^glBlit(Named)?Framebuffer")
+
+set(uploadPatterns
+    "^gl(Named)?Buffer(Sub)?Data"
+    "^gl(Named)?BufferStorage"
+    "^glTex(ture)?(Sub)?Image"
+    "^glTex(ture)?Storage"
+    "^glCompressedTex(ture)?(Sub)?Image"
+    "^gl(Un)?Map(Named)?Buffer"
+    "^glFlushMapped"
+    "^glCopy(Named)?BufferSubData"
+    "^glClear(Named)?Buffer(Sub)?Data"
+    "^glClearTex(Sub)?Image")
+
+set(statePatterns
+    "^gl(Bind|Enable|Disable|UseProgram|Uniform|ProgramUniform|Blend|ColorMask|Stencil|Viewport|Scissor)"
+    "^gl(CullFace|FrontFace|PolygonMode|PolygonOffset|LineWidth|PointSize|PointParameter|LogicOp|Hint)"
+    "^gl(VertexArray|VertexBinding|VertexAttribBinding|VertexAttribDivisor|VertexBindingDivisor)"
+    "^glVertexAttrib[IL]?(Format|Pointer)"
+    "^gl(PixelStore|ActiveTexture|TexParameter|TextureParameter|SamplerParameter|PatchParameter)"
+    "^gl(PrimitiveRestartIndex|ClipControl|ProvokingVertex|SampleMask|MinSampleShading)"
+    "^gl(ReadBuffer|DrawBuffer|NamedFramebufferDrawBuffer|NamedFramebufferReadBuffer)"
+    "^glDepth(Func|Mask|Range|Bounds)"
+    "^glClear(Color|Depth|Stencil)")
+
+# CMake regular expressions are limited to a few groups, so each category is a list of them
+function(matches_any name patterns result)
+    foreach (pattern ${${patterns}})
+        if (name MATCHES "${pattern}")
+            set(${result} TRUE PARENT_SCOPE)
+            return()
+        endif ()
+    endforeach ()
+
+    set(${result} FALSE PARENT_SCOPE)
+endfunction()
+
+set(shims "")
+set(functions "")
+set(installs "")
+set(removes "")
+set(index 0)
+
+foreach (name type returnType parameters arguments IN ZIP_LISTS gladNames gladTypes gladReturnTypes gladParameters gladArguments)
+    if (arguments STREQUAL "-")
+        set(arguments "")
+    endif ()
+
+    matches_any(${name} drawPatterns draw)
+    matches_any(${name} uploadPatterns upload)
+    matches_any(${name} statePatterns state)
+
+    if (draw)
+        set(category GlCallCategoryDraw)
+    elseif (upload)
+        set(category GlCallCategoryUpload)
+    elseif (state)
+        set(category GlCallCategoryState)
+    else ()
+        set(category GlCallCategoryOther)
+    endif ()
+
+    string(APPEND shims "static ${type} real_${name} = nullptr;\n\n")
+    string(APPEND shims "static ${returnType} APIENTRY trace_${name}(${parameters})\n{\n")
+    string(APPEND shims "    countGlCall(${index});\n\n    return real_${name}(${arguments});\n}\n\n")
+
+    string(APPEND functions "    {\"${name}\", ${category}},\n")
+
+    string(APPEND installs "    if (glad_${name} != nullptr && glad_${name} != trace_${name})\n    {\n")
+    string(APPEND installs "        real_${name} = glad_${name};\n        glad_${name} = trace_${name};\n    }\n\n")
+
+    string(APPEND removes "    if (glad_${name} == trace_${name})\n    {\n        glad_${name} = real_${name};\n    }\n\n")
+
+    math(EXPR index "${index} + 1")
+endforeach ()
+
+get_filename_component(headerName ${GLAD_HEADER} NAME)
+
+set(source "// Generated by GenerateGlTrace.cmake from ${headerName}, do not edit.\n\n")
+string(APPEND source "#include \"gltraceshims.hpp\"\n\n")
+string(APPEND source "${shims}")
+string(APPEND source "const GlFunctionInfo glFunctionInfos[] = {\n${functions}};\n\n")
+string(APPEND source "const int glFunctionInfoCount = ${index};\n\n")
+string(APPEND source "void installGlShims()\n{\n${installs}}\n\n")
+string(APPEND source "void removeGlShims()\n{\n${removes}}\n")
+
+file(WRITE ${OUTPUT} "${source}")
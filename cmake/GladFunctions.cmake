@@ -0,0 +1,72 @@
+# read_glad_functions(<glad.h>)
+#
+# Reads the GL functions glad.h declares into parallel lists for the generators that wrap the glad
+# function table: gladNames (glCullFace), gladTypes (PFNGLCULLFACEPROC), gladReturnTypes (void),
+# gladParameters (GLenum mode) and gladArguments (mode). The argument list of a function is the last
+# identifier of each of its parameters. Both are comma separated, a function without parameters has
+# "void" and "-", because empty list elements get lost.
+
+function(read_glad_functions header)
+    file(READ ${header} content)
+
+    # typedef <return type> (APIENTRYP PFNGL<NAME>PROC)(<parameters>);
+    string(REGEX MATCHALL "typedef [^\n;(]+ \\(APIENTRYP PFNGL[A-Z0-9_]+PROC\\)\\([^\n;]*\\)" typedefs "${content}")
+
+    # GLAPI PFNGL<NAME>PROC glad_gl<Name>;
+    string(REGEX MATCHALL "GLAPI PFNGL[A-Z0-9_]+PROC glad_gl[A-Za-z0-9_]+" pointers "${content}")
+
+    foreach (pointer ${pointers})
+        string(REGEX REPLACE "GLAPI (PFNGL[A-Z0-9_]+PROC) glad_(gl[A-Za-z0-9_]+)" "\\1;\\2" parts "${pointer}")
+        list(GET parts 0 type)
+        list(GET parts 1 name)
+        set(functionName_${type} ${name})
+    endforeach ()
+
+    set(names "")
+    set(types "")
+    set(returnTypes "")
+    set(parameterLists "")
+    set(argumentLists "")
+
+    foreach (typedef ${typedefs})
+        string(REGEX REPLACE "typedef ([^(]+) \\(APIENTRYP (PFNGL[A-Z0-9_]+PROC)\\)\\((.*)\\)" "\\1" returnType "${typedef}")
+        string(REGEX REPLACE "typedef ([^(]+) \\(APIENTRYP (PFNGL[A-Z0-9_]+PROC)\\)\\((.*)\\)" "\\2" type "${typedef}")
+        string(REGEX REPLACE "typedef ([^(]+) \\(APIENTRYP (PFNGL[A-Z0-9_]+PROC)\\)\\((.*)\\)" "\\3" parameters "${typedef}")
+
+        set(name ${functionName_${type}})
+
+        if (NOT name)
+            continue()
+        endif ()
+
+        set(arguments "")
+
+        if (NOT parameters STREQUAL "void")
+            string(REPLACE "," ";" parameterList "${parameters}")
+
+            foreach (parameter ${parameterList})
+                string(REGEX MATCH "[A-Za-z_][A-Za-z0-9_]*[ ]*$" argument "${parameter}")
+                string(STRIP "${argument}" argument)
+                list(APPEND arguments ${argument})
+            endforeach ()
+        endif ()
+
+        string(REPLACE ";" ", " arguments "${arguments}")
+
+        if (arguments STREQUAL "")
+            set(arguments "-")
+        endif ()
+
+        list(APPEND names ${name})
+        list(APPEND types ${type})
+        list(APPEND returnTypes "${returnType}")
+        list(APPEND parameterLists "${parameters}")
+        list(APPEND argumentLists "${arguments}")
+    endforeach ()
+
+    set(gladNames ${names} PARENT_SCOPE)
+    set(gladTypes ${types} PARENT_SCOPE)
+    set(gladReturnTypes "${returnTypes}" PARENT_SCOPE)
+    set(gladParameters "${parameterLists}" PARENT_SCOPE)
+    set(gladArguments "${argumentLists}" PARENT_SCOPE)
+endfunction()
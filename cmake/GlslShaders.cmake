@@ -0,0 +1,34 @@
+# playground_add_glsl_shaders(<target> <glsl sources...>)
+#
+# Embeds GLSL sources into <target> as text, for compiling them at runtime. For every source a
+# header named after it (triangle.vert -> triangle.vert.glsl.hpp) is generated, holding a string
+# called after the file name (triangle_vert_glsl) that can be passed to Shader::compile. Together
+# with playground_add_spirv_shaders this keeps the SPIR-V and its GLSL fallback on one source.
+
+set(PLAYGROUND_EMBED_GLSL_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/EmbedGlsl.cmake)
+
+function(playground_add_glsl_shaders target)
+    set(outputDir ${CMAKE_CURRENT_BINARY_DIR}/glsl)
+    set(headers "")
+
+    foreach (source ${ARGN})
+        get_filename_component(sourcePath ${source} ABSOLUTE)
+        get_filename_component(sourceName ${source} NAME)
+        string(MAKE_C_IDENTIFIER ${sourceName}_glsl identifier)
+
+        set(header ${outputDir}/${sourceName}.glsl.hpp)
+
+        add_custom_command(
+            OUTPUT ${header}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${outputDir}
+            COMMAND ${CMAKE_COMMAND} -DSOURCE=${sourcePath} -DHEADER=${header} -DIDENTIFIER=${identifier} -P ${PLAYGROUND_EMBED_GLSL_SCRIPT}
+            DEPENDS ${sourcePath} ${PLAYGROUND_EMBED_GLSL_SCRIPT}
+            COMMENT "Embedding ${sourceName}"
+            VERBATIM)
+
+        list(APPEND headers ${header})
+    endforeach ()
+
+    target_sources(${target} PRIVATE ${headers})
+    target_include_directories(${target} PRIVATE ${outputDir})
+endfunction()
@@ -0,0 +1,41 @@
+# playground_add_spirv_shaders(<target> <glsl sources...>)
+#
+# Compiles GLSL sources to SPIR-V at build time and embeds them into <target>. The stage follows
+# from the extension (.vert, .frag, .comp, .geom, .tesc, .tese). For every source a header named
+# after it (triangle.vert -> triangle.vert.hpp) is generated, holding a SpirvModule called after
+# the file name (triangle_vert) that can be passed to Shader::loadSpirv.
+#
+# SPIR-V programs have no uniform names at runtime, give every uniform an explicit
+# layout(location = N); these are picked up as the module's reflection so setUniform keeps working.
+
+set(PLAYGROUND_EMBED_SPIRV_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/EmbedSpirv.cmake)
+
+function(playground_add_spirv_shaders target)
+    find_program(GLSLANG_VALIDATOR NAMES glslangValidator glslang REQUIRED)
+
+    set(outputDir ${CMAKE_CURRENT_BINARY_DIR}/spirv)
+    set(headers "")
+
+    foreach (source ${ARGN})
+        get_filename_component(sourcePath ${source} ABSOLUTE)
+        get_filename_component(sourceName ${source} NAME)
+        string(MAKE_C_IDENTIFIER ${sourceName} identifier)
+
+        set(spirv ${outputDir}/${sourceName}.spv)
+        set(header ${outputDir}/${sourceName}.hpp)
+
+        add_custom_command(
+            OUTPUT ${header}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${outputDir}
+            COMMAND ${GLSLANG_VALIDATOR} -G -o ${spirv} ${sourcePath}
+            COMMAND ${CMAKE_COMMAND} -DSOURCE=${sourcePath} -DSPIRV=${spirv} -DHEADER=${header} -DIDENTIFIER=${identifier} -P ${PLAYGROUND_EMBED_SPIRV_SCRIPT}
+            DEPENDS ${sourcePath} ${PLAYGROUND_EMBED_SPIRV_SCRIPT}
+            COMMENT "Compiling ${sourceName} to SPIR-V"
+            VERBATIM)
+
+        list(APPEND headers ${header})
+    endforeach ()
+
+    target_sources(${target} PRIVATE ${headers})
+    target_include_directories(${target} PRIVATE ${outputDir})
+endfunction()
@@ -0,0 +1,81 @@
+#ifndef COMPUTESHADER_HPP
+#define COMPUTESHADER_HPP
+
+#include <shader.hpp>
+
+enum MemoryBarriers
+{
+    MemoryBarrierNone = 0,
+    MemoryBarrierVertexAttribArray = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+    MemoryBarrierElementArray = GL_ELEMENT_ARRAY_BARRIER_BIT,
+    MemoryBarrierUniform = GL_UNIFORM_BARRIER_BIT,
+    MemoryBarrierTextureFetch = GL_TEXTURE_FETCH_BARRIER_BIT,
+    MemoryBarrierImageAccess = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT,
+    MemoryBarrierCommand = GL_COMMAND_BARRIER_BIT,
+    MemoryBarrierBufferUpdate = GL_BUFFER_UPDATE_BARRIER_BIT,
+    MemoryBarrierTextureUpdate = GL_TEXTURE_UPDATE_BARRIER_BIT,
+    MemoryBarrierFramebuffer = GL_FRAMEBUFFER_BARRIER_BIT,
+    MemoryBarrierAtomicCounter = GL_ATOMIC_COUNTER_BARRIER_BIT,
+    MemoryBarrierShaderStorage = GL_SHADER_STORAGE_BARRIER_BIT,
+    MemoryBarrierQueryBuffer = GL_QUERY_BUFFER_BARRIER_BIT,
+    MemoryBarrierAll = static_cast<int>(GL_ALL_BARRIER_BITS),
+};
+
+inline MemoryBarriers operator|(
+    MemoryBarriers a,
+    MemoryBarriers b)
+{
+    return static_cast<MemoryBarriers>(static_cast<int>(a) | static_cast<int>(b));
+}
+
+/// Make shader writes visible to the kinds of access given in barriers, see glMemoryBarrier.
+void memoryBarrier(
+    MemoryBarriers barriers);
+
+class ComputeShader : public Shader
+{
+public:
+    ComputeShader();
+
+    virtual ~ComputeShader();
+
+    /// Compile the compute program. Its local work group size is reflected with every new program.
+    bool compile(
+        const std::string &compShaderStr);
+
+    /// Link the compute program from precompiled SPIR-V.
+    bool loadSpirv(
+        const SpirvModule &compModule,
+        const SpecializationConstants &constants = SpecializationConstants());
+
+    /// The local_size_x/y/z declared by the compute shader.
+    const glm::uvec3 &workGroupSize() const;
+
+    /// Dispatch the given number of work groups.
+    void dispatch(
+        GLuint groupsX,
+        GLuint groupsY = 1,
+        GLuint groupsZ = 1);
+
+    /// Dispatch enough work groups to cover the given number of invocations in each dimension.
+    void dispatchInvocations(
+        GLuint countX,
+        GLuint countY = 1,
+        GLuint countZ = 1);
+
+    /// Dispatch with the work group counts read from a GL_DISPATCH_INDIRECT_BUFFER at offset.
+    void dispatchIndirect(
+        GLuint buffer,
+        GLintptr offset = 0);
+
+protected:
+    /// Every new program, however it was built, may declare a different local_size_x/y/z.
+    void programChanged() override;
+
+private:
+    glm::uvec3 _workGroupSize = glm::uvec3(1, 1, 1);
+
+    void reflectWorkGroupSize();
+};
+
+#endif // COMPUTESHADER_HPP
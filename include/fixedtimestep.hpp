@@ -0,0 +1,48 @@
+#ifndef FIXEDTIMESTEP_HPP
+#define FIXEDTIMESTEP_HPP
+
+#include <cstdint>
+#include <functional>
+
+/// Splits variable frame times into fixed simulation steps. Time that is left over carries into
+/// the next frame and is reported as the interpolation factor between the last two steps.
+class FixedTimestep
+{
+public:
+    FixedTimestep(
+        double stepsPerSecond = 60.0,
+        int maxStepsPerFrame = 8);
+
+    virtual ~FixedTimestep();
+
+    void setStepsPerSecond(
+        double stepsPerSecond);
+
+    /// More steps than this in one frame and the rest of the backlog is dropped, so a slow update cannot snowball.
+    void setMaxStepsPerFrame(
+        int maxStepsPerFrame);
+
+    /// Fixed delta time of one step in seconds.
+    double stepTime() const;
+
+    /// Add the time the last frame took and call update for every step that is due. Returns the
+    /// interpolation factor in [0, 1) between the previous and the current simulation state.
+    double advance(
+        double frameTime,
+        const std::function<void(double)> &update);
+
+    /// Steps taken since construction.
+    uint64_t stepCount() const;
+
+    /// Simulation time dropped by the max steps cap, in seconds.
+    double droppedTime() const;
+
+private:
+    double _stepTime;
+    int _maxStepsPerFrame;
+    double _accumulator = 0.0;
+    uint64_t _stepCount = 0;
+    double _droppedTime = 0.0;
+};
+
+#endif // FIXEDTIMESTEP_HPP
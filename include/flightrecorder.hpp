@@ -0,0 +1,102 @@
+#ifndef FLIGHTRECORDER_HPP
+#define FLIGHTRECORDER_HPP
+
+#include <array>
+#include <cstdint>
+#include <framestats.hpp>
+#include <future>
+#include <gltrace.hpp>
+#include <gpuprofiler.hpp>
+#include <string>
+#include <vector>
+
+/// Keeps the last frames' timings in a fixed-size ring and writes a Chrome trace when a frame takes
+/// longer than a multiple of the rolling median. The trace holds the CPU scopes of all threads
+/// (see PROFILE_SCOPE), the GPU scopes (see GPU_SCOPE) and a track with the frames themselves, with
+/// counters of the frames' GL calls while glTrace() is enabled. The trace is written once the GPU
+/// timings of the hitch frame are read back, up to GpuProfiler::FrameLatency frames later. It is off
+/// by default.
+class FlightRecorder
+{
+public:
+    static constexpr int MaxGpuScopes = 32;
+
+    FlightRecorder(
+        size_t maxFrames = 2048);
+
+    virtual ~FlightRecorder();
+
+    /// Start watching for hitches, traces go to the current directory unless setOutputDirectory says otherwise.
+    void setEnabled(
+        bool enabled);
+
+    bool isEnabled() const;
+
+    /// A frame is a hitch when its delta time exceeds factor times the rolling median.
+    void setHitchThreshold(
+        double factor);
+
+    /// How many seconds before the hitch end up in the trace.
+    void setHistory(
+        double seconds);
+
+    /// Where hitch traces are written to, named hitch-<frame>.json.
+    void setOutputDirectory(
+        const std::string &directory);
+
+    /// Called by GameLoop at the start of every frame, records the frame that just ended and checks it for a hitch.
+    /// Leave out the GPU timings when the GPU profiler is driven by another thread.
+    void recordFrame(
+        const FrameStats &stats,
+        bool gpuTimings = true);
+
+    /// Write the recorded history to a Chrome trace now.
+    bool dump(
+        const std::string &path);
+
+private:
+    struct Frame
+    {
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        double deltaTime = 0.0;
+        double cpuTime = 0.0;
+        double swapTime = 0.0;
+        bool hitch = false;
+        bool hasGlCalls = false;
+        GlCallCounts glCalls;
+        uint64_t gpuFrameIndex = 0;
+        bool hasGpuFrame = false;
+        int gpuScopeCount = 0;
+        std::array<GpuScopeTiming, MaxGpuScopes> gpuScopes;
+    };
+
+    bool _enabled = false;
+    double _hitchThreshold = 2.5;
+    double _history = 5.0;
+    std::string _outputDirectory = ".";
+    std::vector<Frame> _frames;
+    uint64_t _frameCount = 0;
+    uint64_t _frameBegin = 0;
+    uint64_t _gpuFrameIndex = 0;
+    bool _hasGpuFrame = false;
+    uint64_t _lastGpuFrameIndex = 0;
+    uint64_t _lastDump = 0;
+    std::future<bool> _pendingDump;
+
+    // A hitch whose trace waits for the GPU timings of its frame
+    bool _hitchPending = false;
+    uint64_t _hitchFrame = 0;
+    uint64_t _hitchEnd = 0;
+    bool _hitchHasGpuFrame = false;
+    uint64_t _hitchGpuFrameIndex = 0;
+
+    void attachGpuFrame();
+
+    /// Trace the history up to end, and the frames recorded since.
+    std::future<bool> startDump(
+        const std::string &path,
+        uint64_t end);
+};
+
+#endif // FLIGHTRECORDER_HPP
@@ -0,0 +1,42 @@
+#ifndef FRAMELIMITER_HPP
+#define FRAMELIMITER_HPP
+
+#include <chrono>
+#include <cstdint>
+
+/// Paces frames to a target rate. It sleeps while the deadline is further away than the sleep
+/// overshoot it has measured so far and spins for the rest, which keeps the pacing precise without
+/// burning a core for the whole wait.
+class FrameLimiter
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FrameLimiter();
+
+    virtual ~FrameLimiter();
+
+    /// Frames per second to pace to, 0 disables the limiter.
+    void setFrameRate(
+        double frameRate);
+
+    double frameRate() const;
+
+    /// Called by GameLoop once per frame, returns once the next frame is due.
+    void wait();
+
+private:
+    double _frameRate = 0.0;
+    Clock::time_point _deadline;
+    bool _highResolutionTimer = false;
+
+    // Running mean and variance of how long a 1 ms sleep really takes, in seconds
+    double _sleepEstimate = 0.005;
+    double _sleepMean = 0.005;
+    double _sleepM2 = 0.0;
+    uint64_t _sleepCount = 1;
+
+    void sleep();
+};
+
+#endif // FRAMELIMITER_HPP
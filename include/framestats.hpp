@@ -0,0 +1,76 @@
+#ifndef FRAMESTATS_HPP
+#define FRAMESTATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/// Distribution of one frame time metric over the rolling window, in seconds.
+struct FrameTimeSummary
+{
+    double average = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/// Frame timing as measured by OpenGLApp::GameLoop with a monotonic clock. For every frame it keeps
+/// the delta to the previous frame, the CPU time the application spent on it and the time spent in
+/// the buffer swap, over a rolling window of the last frames.
+class FrameStats
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FrameStats(
+        size_t windowSize = 240);
+
+    virtual ~FrameStats();
+
+    /// Called by GameLoop before presenting, this ends the CPU part of the frame.
+    void beginPresent();
+
+    /// Called by GameLoop when the swap returned.
+    void endPresent();
+
+    /// Called by GameLoop right before it hands control back to the application for the next frame.
+    void beginFrame();
+
+    /// Called by GameLoop after it waited idle for a reason to redraw, the wait is not counted as part of the frame.
+    void skipIdle(
+        Clock::duration idle);
+
+    /// Number of frames measured so far.
+    uint64_t frameCount() const;
+
+    /// Time between the start of the last frame and the one before it.
+    double deltaTime() const;
+
+    /// CPU time the application spent on the last frame, excluding the swap and message handling.
+    double cpuTime() const;
+
+    /// Time spent in the buffer swap of the last frame.
+    double swapTime() const;
+
+    FrameTimeSummary deltaTimeSummary() const;
+
+    FrameTimeSummary cpuTimeSummary() const;
+
+    FrameTimeSummary swapTimeSummary() const;
+
+private:
+    std::vector<double> _deltaTimes;
+    std::vector<double> _cpuTimes;
+    std::vector<double> _swapTimes;
+    size_t _next = 0;
+    uint64_t _frameCount = 0;
+    Clock::time_point _frameStart;
+    Clock::time_point _presentStart;
+    Clock::time_point _presentEnd;
+
+    FrameTimeSummary summarize(
+        const std::vector<double> &times) const;
+};
+
+#endif // FRAMESTATS_HPP
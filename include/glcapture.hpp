@@ -0,0 +1,132 @@
+#ifndef GLCAPTURE_HPP
+#define GLCAPTURE_HPP
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// How a pointer parameter is stored in a capture.
+enum GlCaptureTags
+{
+    GlCaptureTagValue = 0,   // The pointer itself, an offset into a bound buffer, as a u64
+    GlCaptureTagData,        // The memory it points to: a u64 size, padding to 8 bytes and the data
+    GlCaptureTagOutput,      // Memory the call writes to, a u64 size the replay needs at least, 0 when unknown
+    GlCaptureTagUnsupported, // Memory of unknown size, the replay skips the call
+    GlCaptureTagStrings,     // An array of strings: a u32 count, then a u64 length, the characters and a 0 for each
+};
+
+/// Captures the GL calls of an app with the data they pass, buffer contents, pixels and shader sources
+/// included, to a file playground-replay re-issues them from. The objects a frame uses are created by
+/// the calls before it, so a capture starts when the context is created and ends after a number of
+/// frames. It only exists when the library is built with PLAYGROUND_GL_CAPTURE, which is off by default.
+///
+/// A capture is a header with the size and framebuffer the app rendered to and the names of all entry
+/// points, followed by a record per call: the u16 index of the entry point, the parameters in order
+/// and what the call returned. Scalars are stored as they are, pointers as one of GlCaptureTags.
+/// Writes to mapped buffers are captured when they are flushed or unmapped, writes to persistently
+/// mapped buffers that are never flushed are not. Calls that take callbacks are not captured.
+class GlCapture
+{
+public:
+    static constexpr uint16_t FrameEnd = 0xffff;
+
+    /// A write to a mapped buffer: the u64 pointer the capture mapped, a u64 offset into it and the data like GlCaptureTagData.
+    static constexpr uint16_t MappedWrite = 0xfffe;
+
+    GlCapture();
+
+    virtual ~GlCapture();
+
+    /// Install the shims over the functions of the current context and capture every call from now on
+    /// to path, until frames frames ended or stop() is called, 0 for no limit. The size and framebuffer
+    /// are what the app renders to, the replay draws to its own framebuffer instead.
+    bool start(
+        const std::string &path,
+        int frames,
+        int width,
+        int height,
+        unsigned int framebuffer);
+
+    void stop();
+
+    bool isCapturing() const;
+
+    /// Called by GameLoop after presenting, marks the end of a frame and stops after the last one.
+    void endFrame();
+
+    /// Key of a named buffer's mapping, mappings of buffers bound to a target use the target.
+    static uint64_t namedKey(
+        GLuint buffer)
+    {
+        return (uint64_t(1) << 32) | buffer;
+    }
+
+    /// Called by the shims when a buffer was mapped.
+    void mapped(
+        uint64_t key,
+        void *pointer,
+        GLsizeiptr length,
+        bool writable);
+
+    /// Called by the shims before a mapped range is flushed, captures what was written to it.
+    void flushMapped(
+        uint64_t key,
+        GLintptr offset,
+        GLsizeiptr length);
+
+    /// Called by the shims before a buffer is unmapped, captures what was written to it.
+    void unmapping(
+        uint64_t key);
+
+    /// Size of the buffer bound to target, without capturing the query.
+    GLsizeiptr bufferSize(
+        GLenum target);
+
+    /// Size of a named buffer, without capturing the query.
+    GLsizeiptr namedBufferSize(
+        GLuint buffer);
+
+private:
+    friend class GlCaptureRecord;
+
+    struct Mapping
+    {
+        void *pointer;
+        GLsizeiptr length;
+    };
+
+    std::atomic<bool> _capturing = false;
+    std::mutex _mutex;
+    std::string _path;
+    std::ofstream _file;
+    std::vector<uint8_t> _buffer;
+    uint64_t _written = 0;
+    int _frames = 0;
+    int _capturedFrames = 0;
+    uint64_t _calls = 0;
+    std::vector<bool> _warned;
+    std::unordered_map<uint64_t, Mapping> _mappings;
+
+    // What the glad functions pointed at before the shims, for the queries the capture makes itself
+    PFNGLGETINTEGERVPROC _getIntegerv = nullptr;
+    PFNGLGETBUFFERPARAMETERI64VPROC _getBufferParameteri64v = nullptr;
+    PFNGLGETNAMEDBUFFERPARAMETERI64VPROC _getNamedBufferParameteri64v = nullptr;
+
+    void writeMapped(
+        const Mapping &mapping,
+        GLintptr offset,
+        GLsizeiptr length);
+
+    void flush();
+};
+
+/// The capture openApp and embedApp start with OpenGLApp::glCapturePath.
+GlCapture &glCapture();
+
+#endif // GLCAPTURE_HPP
@@ -0,0 +1,110 @@
+#ifndef GLTRACE_HPP
+#define GLTRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum GlCallCategories
+{
+    GlCallCategoryOther = 0,
+    GlCallCategoryDraw,   // Draws, compute dispatches, clears and blits
+    GlCallCategoryState,  // Binds, enables, uniforms and the rest of the pipeline state
+    GlCallCategoryUpload, // Buffer and texture data, storage allocation, mapping and copies
+    GlCallCategoryCount,
+};
+
+/// GL calls of one frame, by category.
+struct GlCallCounts
+{
+    uint32_t total = 0;
+    uint32_t categories[GlCallCategoryCount] = {0};
+};
+
+/// Calls of one GL entry point in a frame.
+struct GlFunctionCalls
+{
+    const char *name;
+    GlCallCategories category;
+    uint32_t count;
+};
+
+/// Counts the GL calls of every frame per entry point by swapping the glad function pointers for
+/// generated shims, and optionally records them to a compact binary trace. It only exists when the
+/// library is built with PLAYGROUND_GL_TRACE, which is off by default. The shims count calls from
+/// all threads, a ResourceLoader's uploads end up in the frame they happened in.
+///
+/// A trace is a header with the names of all entry points, followed by a record per call and per
+/// frame end. A record is the entry point's index plus 1, or 0 for a frame end, followed by the
+/// nanoseconds since the previous record, both as LEB128 varints.
+class GlTrace
+{
+public:
+    GlTrace();
+
+    virtual ~GlTrace();
+
+    /// Install the shims over the functions of the current context, or remove them. Returns false
+    /// when the library was built without PLAYGROUND_GL_TRACE.
+    bool setEnabled(
+        bool enabled);
+
+    bool isEnabled() const;
+
+    bool startRecording(
+        const std::string &path);
+
+    void stopRecording();
+
+    bool isRecording() const;
+
+    /// Called by GameLoop after presenting, closes the frame's counts and writes the trace records.
+    void endFrame();
+
+    /// Calls of the most recent frame, by category.
+    GlCallCounts lastFrame() const;
+
+    /// Calls of the most recent frame per entry point, the most called first.
+    std::vector<GlFunctionCalls> lastFrameCalls() const;
+
+    /// Log the most called entry points of the last frame.
+    void logLastFrame(
+        size_t maxFunctions = 10) const;
+
+    /// Called by the shims.
+    void count(
+        uint16_t function)
+    {
+        _counts[function].fetch_add(1, std::memory_order_relaxed);
+
+        if (_recording.load(std::memory_order_relaxed))
+        {
+            record(function + 1u);
+        }
+    }
+
+private:
+    bool _enabled = false;
+    std::unique_ptr<std::atomic<uint32_t>[]> _counts;
+    std::atomic<bool> _recording = false;
+
+    mutable std::mutex _mutex;
+    std::vector<uint32_t> _lastFrame;
+    GlCallCounts _lastFrameCounts;
+    std::ofstream _file;
+    std::vector<uint8_t> _buffer;
+    uint64_t _lastRecord = 0;
+    uint64_t _recordedFrames = 0;
+
+    void record(
+        uint32_t code);
+};
+
+/// The trace GameLoop drives with OpenGLApp::countGlCalls.
+GlTrace &glTrace();
+
+#endif // GLTRACE_HPP
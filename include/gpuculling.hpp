@@ -0,0 +1,88 @@
+#ifndef GPUCULLING_HPP
+#define GPUCULLING_HPP
+
+#include <glad/glad.h>
+
+#include <computeshader.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+/// Layout of one record in a GL_DRAW_INDIRECT_BUFFER, as consumed by glMultiDrawElementsIndirect(Count).
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/// Frustum and Hi-Z occlusion culling on the GPU. Every object has a bounding sphere and a draw
+/// command template, the visible ones are compacted into an indirect buffer together with a draw
+/// count, so visibility never has to be read back to the CPU.
+class GpuCulling
+{
+public:
+    GpuCulling();
+
+    // Owns its buffers and textures, a copy would delete them twice
+    GpuCulling(
+        const GpuCulling &) = delete;
+
+    GpuCulling &operator=(
+        const GpuCulling &) = delete;
+
+    virtual ~GpuCulling();
+
+    /// Compile the culling programs and allocate buffers for at most maxObjects objects. Fails when the
+    /// context supports neither GL 4.6 nor ARB_indirect_parameters, draw() needs one of them. Calling
+    /// it again replaces the buffers and Hi-Z pyramid, so the objects have to be set again.
+    bool setup(
+        GLsizei maxObjects);
+
+    /// Upload the world space bounding spheres (xyz = center, w = radius) and draw commands, one of each per object.
+    bool setObjects(
+        const std::vector<glm::vec4> &bounds,
+        const std::vector<DrawElementsIndirectCommand> &commands);
+
+    /// Build the Hi-Z pyramid from a depth texture that was rendered with viewProj. Call this at the
+    /// end of a frame, the next call to cull() tests against it.
+    void buildHiZ(
+        GLuint depthTexture,
+        int width,
+        int height,
+        const glm::mat4 &viewProj);
+
+    /// Cull all objects against the frustum of viewProj and, when available, the Hi-Z pyramid.
+    void cull(
+        const glm::mat4 &viewProj);
+
+    /// Draw the visible objects. The vertex array with the element buffer has to be bound by the caller.
+    void draw(
+        GLenum mode = GL_TRIANGLES,
+        GLenum indexType = GL_UNSIGNED_INT);
+
+    GLuint commandBuffer() const;
+
+    GLuint countBuffer() const;
+
+private:
+    ComputeShader _cullShader;
+    ComputeShader _hiZShader;
+    GLuint _boundsBuffer = 0;
+    GLuint _templateBuffer = 0;
+    GLuint _commandBuffer = 0;
+    GLuint _countBuffer = 0;
+    GLuint _hiZTexture = 0;
+    GLsizei _maxObjects = 0;
+    GLsizei _objectCount = 0;
+    int _hiZWidth = 0;
+    int _hiZHeight = 0;
+    int _hiZLevels = 0;
+    glm::mat4 _hiZViewProj = glm::mat4(1.0f);
+    bool _useIndirectParametersArb = false;
+
+    void release();
+};
+
+#endif // GPUCULLING_HPP
@@ -0,0 +1,126 @@
+#ifndef GPUPROFILER_HPP
+#define GPUPROFILER_HPP
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// GPU time of one profiled scope, relative to the start of its frame, in milliseconds.
+struct GpuScopeTiming
+{
+    const char *name;
+    int depth;
+    double start;
+    double duration;
+};
+
+/// Scoped GPU timing with GL_TIMESTAMP queries. Every frame gets its own set of queries in a ring
+/// that is FrameLatency frames deep, a frame is only read back once its queries are available, so
+/// the profiler never waits on the GPU. Frames the GPU has not finished after FrameLatency frames
+/// are dropped instead.
+class GpuProfiler
+{
+public:
+    static constexpr int FrameLatency = 4;
+
+    GpuProfiler();
+
+    /// Makes no GL calls, the context is usually gone by the time the global profiler is destroyed.
+    virtual ~GpuProfiler();
+
+    /// Delete the queries while the context is still current, called by Cleanup. The profiler starts
+    /// over with new queries when it is used after this.
+    void shutdown();
+
+    /// Enabling takes effect at the next frame. Disabled, scopes cost a single branch.
+    void setEnabled(
+        bool enabled);
+
+    bool isEnabled() const;
+
+    /// Called by GameLoop when a frame starts, reads back the oldest frame in the ring when it is available.
+    void beginFrame();
+
+    /// Called by GameLoop before presenting.
+    void endFrame();
+
+    /// The name has to outlive the profiler, use string literals.
+    void beginScope(
+        const char *name);
+
+    void endScope();
+
+    /// Whether the current frame is being profiled, enabling and disabling only take effect at frame boundaries.
+    bool isRecording() const;
+
+    /// Index of the frame that is being recorded, counting from the first profiled frame. Only meaningful while recording.
+    uint64_t currentFrameIndex() const;
+
+    /// Index of the frame lastFrame() belongs to, counting from the first profiled frame.
+    uint64_t lastFrameIndex() const;
+
+    /// Scopes of the most recent frame that was read back, in the order they were opened. The first
+    /// entry covers the whole frame.
+    const std::vector<GpuScopeTiming> &lastFrame() const;
+
+    /// Log lastFrame() as an indented tree.
+    void logLastFrame() const;
+
+    /// Write lastFrame() as JSON.
+    bool exportLastFrame(
+        const std::string &path) const;
+
+private:
+    struct Scope
+    {
+        const char *name;
+        int depth;
+        GLuint beginQuery;
+        GLuint endQuery;
+    };
+
+    struct Frame
+    {
+        uint64_t index = 0;
+        std::vector<GLuint> queries;
+        size_t usedQueries = 0;
+        std::vector<Scope> scopes;
+        bool pending = false;
+    };
+
+    bool _enabled = false;
+    bool _inFrame = false;
+    uint64_t _frameIndex = 0;
+    Frame _frames[FrameLatency];
+    std::vector<size_t> _openScopes;
+    uint64_t _lastFrameIndex = 0;
+    std::vector<GpuScopeTiming> _lastFrame;
+
+    GLuint nextQuery(
+        Frame &frame);
+
+    void readBack(
+        Frame &frame);
+};
+
+/// The profiler GameLoop drives and GPU_SCOPE records into.
+GpuProfiler &gpuProfiler();
+
+class GpuScope
+{
+public:
+    GpuScope(
+        const char *name);
+
+    ~GpuScope();
+};
+
+#define GPU_SCOPE_CONCAT_(a, b) a##b
+#define GPU_SCOPE_CONCAT(a, b) GPU_SCOPE_CONCAT_(a, b)
+
+/// Time the GPU work issued in the rest of the enclosing block.
+#define GPU_SCOPE(name) GpuScope GPU_SCOPE_CONCAT(gpuScope, __LINE__)(name)
+
+#endif // GPUPROFILER_HPP
@@ -0,0 +1,27 @@
+#ifndef INPUTEVENT_HPP
+#define INPUTEVENT_HPP
+
+#include <cstdint>
+
+enum InputEventTypes
+{
+    InputEventKeyDown,
+    InputEventKeyUp,
+    InputEventButtonDown,
+    InputEventButtonUp,
+    InputEventMouseMove,
+    InputEventResize,
+    InputEventMouseRawMotion,
+};
+
+/// One input event as the backend received it, stamped on the profileNow() clock in nanoseconds.
+struct InputEvent
+{
+    InputEventTypes type;
+    uint64_t timestamp = 0;
+    int code = 0; // KeyboardButtons or MouseButtons
+    int x = 0;    // Mouse position, raw motion or new width
+    int y = 0;    // Mouse position, raw motion or new height
+};
+
+#endif // INPUTEVENT_HPP
@@ -0,0 +1,65 @@
+#ifndef INPUTRECORDING_HPP
+#define INPUTRECORDING_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <inputevent.hpp>
+#include <string>
+#include <vector>
+
+struct OpenGLApp;
+
+/// Records the input events of an OpenGLApp to a compact binary log, and drives the app from such a
+/// log instead of live input. Together with OpenGLApp::fixedDeltaTime a replay simulates exactly what
+/// the recorded session did, which makes real sessions usable as reproducible performance runs.
+///
+/// The log is a header followed by one record per frame that had input: the frame index relative to
+/// the start of the recording, the number of events and the events with their timestamps relative
+/// to the start of the recording. A last record without events marks the end of the recording.
+class InputRecording
+{
+public:
+    InputRecording();
+
+    virtual ~InputRecording();
+
+    bool startRecording(
+        const std::string &path);
+
+    void stopRecording();
+
+    bool isRecording() const;
+
+    /// Load a log and replay it from the next frame on. Live input is ignored while replaying.
+    bool startReplay(
+        const std::string &path,
+        bool quitWhenDone = true);
+
+    void stopReplay();
+
+    bool isReplaying() const;
+
+    /// Called by GameLoop once the backend read the frame's input. Writes the frame's events to the
+    /// log, or feeds the app the events recorded for this frame.
+    void update(
+        OpenGLApp &app);
+
+private:
+    struct Frame
+    {
+        uint64_t index;
+        std::vector<InputEvent> events;
+    };
+
+    std::ofstream _file;
+    uint64_t _recordingStart = 0;
+    uint64_t _frameIndex = 0;
+
+    std::vector<Frame> _frames;
+    size_t _nextFrame = 0;
+    bool _replaying = false;
+    bool _quitWhenDone = true;
+    uint64_t _replayStart = 0;
+};
+
+#endif // INPUTRECORDING_HPP
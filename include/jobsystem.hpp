@@ -0,0 +1,120 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+struct Job;
+struct JobQueue;
+
+/// Counts the unfinished jobs it was passed to. Jobs queued with runAfter() start once it drops to zero,
+/// so do not reuse a counter while such jobs are still waiting on it.
+class JobCounter
+{
+public:
+    JobCounter();
+
+    virtual ~JobCounter();
+
+    bool isDone() const;
+
+private:
+    std::atomic<int> _count = 0;
+    std::mutex _mutex;
+    std::vector<Job *> _continuations;
+
+    friend class JobSystem;
+};
+
+/// Work-stealing scheduler. Every worker owns a Chase-Lev deque it pushes to and pops from at the
+/// bottom, idle workers steal from the top of the others. The thread that creates the job system is
+/// its main thread: it has a deque too, helps out while it waits and is the only thread that runs
+/// the jobs queued with runOnMainThread(), which is where GL work belongs.
+class JobSystem
+{
+public:
+    /// A negative count starts a worker per hardware thread but one, the main thread is the last one. With
+    /// 0 workers all jobs run on the main thread while it waits.
+    JobSystem(
+        int workerCount = -1);
+
+    virtual ~JobSystem();
+
+    int workerCount() const;
+
+    /// Queue a job for any thread. When given, the counter is increased now and decreased when the job finished.
+    void run(
+        std::function<void()> job,
+        JobCounter *counter = nullptr);
+
+    /// Queue a job that starts once dependency drops to zero.
+    void runAfter(
+        JobCounter &dependency,
+        std::function<void()> job,
+        JobCounter *counter = nullptr);
+
+    /// Queue a job for the main thread, it runs in runMainThreadJobs() or while the main thread waits.
+    void runOnMainThread(
+        std::function<void()> job,
+        JobCounter *counter = nullptr);
+
+    /// Run what was queued for the main thread. Call it once per frame from the main thread.
+    void runMainThreadJobs();
+
+    /// Block until the counter drops to zero, running other jobs meanwhile.
+    void wait(
+        JobCounter &counter);
+
+    /// Call body with consecutive subranges of [begin, end) in parallel and wait for all of them. A grain
+    /// size of 0 splits the range into a few chunks per thread.
+    void parallelFor(
+        size_t begin,
+        size_t end,
+        size_t grainSize,
+        const std::function<void(size_t, size_t)> &body);
+
+private:
+    std::vector<std::unique_ptr<JobQueue>> _queues;
+    std::vector<std::thread> _workers;
+    std::thread::id _mainThread;
+
+    // Jobs pushed by threads that have no deque of their own, or that found theirs full
+    std::mutex _sharedMutex;
+    std::deque<Job *> _sharedJobs;
+
+    std::mutex _mainThreadMutex;
+    std::deque<Job *> _mainThreadJobs;
+
+    std::atomic<int> _queuedJobs = 0;
+    std::atomic<int> _sleepers = 0;
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+    std::atomic<bool> _stop = false;
+
+    void workerLoop(
+        int index);
+
+    void push(
+        Job *job);
+
+    Job *findJob(
+        int index);
+
+    void execute(
+        Job *job);
+
+    void finish(
+        JobCounter *counter);
+
+    int queueIndex() const;
+};
+
+#endif // JOBSYSTEM_HPP
@@ -1,7 +1,18 @@
 #ifndef OPENGLAPP_HPP
 #define OPENGLAPP_HPP
 
+#include <atomic>
+#include <flightrecorder.hpp>
+#include <framestats.hpp>
 #include <functional>
+#include <gltrace.hpp>
+#include <inputevent.hpp>
+#include <inputrecording.hpp>
+#include <string>
+#include <vector>
+
+class RenderThread;
+class ResourceLoader;
 
 enum KeyboardButtons
 {
@@ -146,6 +157,48 @@ enum KeyButtonStates
     KeyButtonStateReleased = -1,
 };
 
+enum SwapIntervals
+{
+    SwapIntervalImmediate = 0,
+    SwapIntervalVSync = 1,
+    SwapIntervalAdaptive = -1, // VSync, but late frames are presented right away and tear instead of waiting a full interval
+};
+
+enum DebugOutputModes
+{
+    DebugOutputDefault = 0, // The PLAYGROUND_GL_DEBUG environment variable (off, async or sync), else the mode the library was built with
+    DebugOutputOff,
+    DebugOutputAsync, // Messages are logged on a background thread, the driver keeps running asynchronously
+    DebugOutputSync,  // Messages are logged in the call that raised them, slow but the stack shows the culprit
+};
+
+enum DepthStencilFormats
+{
+    DepthStencilFormatNone = 0, // No depth buffer, for 2D
+    DepthStencilFormatDepth16,
+    DepthStencilFormatDepth24,
+    DepthStencilFormatDepth24Stencil8,
+};
+
+/// What openApp and embedApp ask for when creating the context and its default framebuffer.
+struct ContextOptions
+{
+    /// Core profile, or the compatibility profile with false.
+    bool coreProfile = true;
+
+    /// A GL_KHR_no_error context, which skips error checking: errors are undefined behaviour and debug
+    /// output only reports what is not an error. Meant for release builds, ignored where unsupported.
+    bool noError = false;
+
+    /// MSAA samples of the default framebuffer, 0 for none.
+    int samples = 0;
+
+    /// An sRGB capable default framebuffer, writes are encoded once GL_FRAMEBUFFER_SRGB is enabled.
+    bool srgb = false;
+
+    DepthStencilFormats depthStencil = DepthStencilFormatDepth24;
+};
+
 struct OpenGLApp
 {
     /// The title of the window to create.
@@ -163,12 +216,20 @@ struct OpenGLApp
     ///
     int mousePosY = 0;
 
-    ///
+    /// Mouse movement over the current frame, previous minus current position. Summed from raw input
+    /// when the backend has it, so it is not limited by the cursor reaching the screen edge.
     int mouseDiffX = 0;
 
-    ///
+    /// See mouseDiffX.
     int mouseDiffY = 0;
 
+    /// Read relative mouse motion from raw input instead of cursor positions. Set before opening the app.
+    bool rawMouseInput = true;
+
+    /// Also queue every raw mouse motion sample as an InputEventMouseRawMotion, for input handling that
+    /// needs more than the per-frame sum.
+    bool rawMouseSamples = false;
+
     ///
     KeyButtonStates KeyStates[KeyboardButtonsCount] = {KeyButtonStateUp};
 
@@ -214,6 +275,132 @@ struct OpenGLApp
     ///
     bool isResizedInCurrentFrame = false;
 
+    /// Input events received since the current frame started, in the order they arrived. Unlike the
+    /// polled states these keep a key that was pressed and released within one frame.
+    std::vector<InputEvent> inputEvents;
+
+    /// Called by the backends for every input event, dropped while inputRecording replays.
+    void addInputEvent(
+        const InputEvent &event);
+
+    /// Queue an event and update the polled states with it.
+    void applyInputEvent(
+        const InputEvent &event);
+
+    /// Records the input to a log, or replays a log instead of live input.
+    InputRecording inputRecording;
+
+    /// When not 0, runApp advances the simulation by this many seconds per frame instead of the measured
+    /// delta time, so replaying recorded input reproduces the session regardless of the frame rate.
+    /// Only runApp uses it: frameStats keeps measuring wall-clock time, since that is what a replay
+    /// benchmarks, so loops written as while (app.GameLoop()) have to pick it over frameStats.deltaTime()
+    /// themselves to replay deterministically.
+    double fixedDeltaTime = 0.0;
+
+    /// Called by GameLoop when a frame ends, ages the keys and buttons that changed during it and clears the queue.
+    void ageInput();
+
+    /// Set to make GameLoop return false at the start of the next frame.
+    bool quit = false;
+
+    /// Only produce a frame when something changed: GameLoop blocks until input arrives, the window is
+    /// resized or exposed, redrawInterval passes or requestRedraw() is called. Time spent waiting is
+    /// not counted in frameStats, so the next delta time does not include it.
+    bool onDemandRendering = false;
+
+    /// With onDemandRendering, produce a frame at least this often in seconds, 0 to only redraw when something changed.
+    double redrawInterval = 0.0;
+
+    /// Make the next frame happen with onDemandRendering, safe to call from any thread. Call it every
+    /// frame while animating.
+    void requestRedraw();
+
+    /// Wake a GameLoop that waits for a reason to redraw, from any thread. Set by openApp and embedApp.
+    std::function<void()> Wake;
+
+    /// The framebuffer the app renders to: 0 for a window, an offscreen framebuffer for the headless backend.
+    unsigned int framebuffer = 0;
+
+    /// Frame delta, CPU frame time and swap time of the last frames, measured by GameLoop.
+    FrameStats frameStats;
+
+    /// Applied by GameLoop whenever it changes. Adaptive falls back to VSync when the driver does not support it.
+    /// Atomic because a RenderThread presents, and reads it, on its own thread.
+    std::atomic<SwapIntervals> swapInterval = SwapIntervalVSync;
+
+    /// Frames per second GameLoop paces to with a sleep+spin limiter, 0 for no limit.
+    double maxFrameRate = 0.0;
+
+    /// Profile, error checking and default framebuffer format of the context. Set before opening the app.
+    ContextOptions contextOptions;
+
+    /// How GL debug messages are handled. Repeats of a message are only counted and the rate of messages
+    /// that reach the log is limited. Set before opening the app.
+    DebugOutputModes debugOutput = DebugOutputDefault;
+
+    /// Count the GL calls of every frame through glTrace(), needs the library built with PLAYGROUND_GL_TRACE.
+    /// Set before opening the app, glTrace() can record the calls to a file on top of that.
+    bool countGlCalls = false;
+
+    /// The GL calls of the last frame by category, with countGlCalls. Updated by GameLoop.
+    GlCallCounts glCalls;
+
+    /// Capture the GL calls from opening the app on, with the data they pass, to this file for
+    /// playground-replay. Needs the library built with PLAYGROUND_GL_CAPTURE, empty for no capture.
+    std::string glCapturePath;
+
+    /// Frames glCapturePath captures before it stops, 0 to capture until the app is closed.
+    int glCaptureFrames = 0;
+
+    /// How many frames the GPU may lag behind the CPU before GameLoop waits for it, 0 leaves the queue depth to the driver.
+    int maxFramesInFlight = 2;
+
+    /// Writes a trace of the last seconds when a frame hitches, off by default. Enable and configure it before the first frame.
+    FlightRecorder flightRecorder;
+
+    // Keys and buttons ageInput() has to look at, and the ones released in the frame they were pressed in
+    std::vector<int> _changedKeys;
+    std::vector<int> _pendingKeyReleases;
+    std::vector<int> _changedButtons;
+    std::vector<int> _pendingButtonReleases;
+    // Whether relative raw motion came in this frame, and the cursor differences of the frame that it replaces
+    bool _rawMouseActive = false;
+    int _cursorDiffX = 0;
+    int _cursorDiffY = 0;
+    bool _hasMousePosition = false;
+    std::atomic<bool> _redrawRequested = false;
+    FrameStats::Clock::time_point _lastRedraw;
+
+    /// Called by runApp at a fixed rate with the fixed delta time in seconds.
+    std::function<void(double)> Update;
+
+    /// Called by runApp once per frame with the interpolation factor in [0, 1) between the last two updates.
+    std::function<void(double)> Render;
+
+    /// Updates per second runApp simulates at, independent of the display rate.
+    double updateRate = 60.0;
+
+    /// Most updates runApp calls in one frame to catch up, the rest of the backlog is dropped.
+    int maxUpdatesPerFrame = 8;
+
+    /// Make the GL context current on the calling thread, or release it with false. Set by openApp and embedApp.
+    std::function<bool(bool)> MakeCurrent;
+
+    /// End the GPU frame and swap the buffers on the thread the context is current on. Set by openApp and embedApp.
+    std::function<void()> Present;
+
+    /// Set while a RenderThread owns the context, GameLoop then hands it the frame instead of presenting.
+    RenderThread *renderThread = nullptr;
+
+    /// Create a second context that shares objects with the main one, for a ResourceLoader. Set before opening the app.
+    bool backgroundLoading = false;
+
+    /// Make the loader context current on the calling thread, or release it with false. Only set with backgroundLoading.
+    std::function<bool(bool)> MakeLoaderCurrent;
+
+    /// Set while a ResourceLoader runs, present hands it finished uploads.
+    ResourceLoader *resourceLoader = nullptr;
+
     /// This function is used to check if the app is still running.
     std::function<bool()> GameLoop;
 
@@ -221,7 +408,8 @@ struct OpenGLApp
     std::function<int()> Cleanup;
 };
 
-/// Open an GL window. This will create a (fullscreen) window with an OpenGL 4.6 context.
+/// Open an GL window. This will create a (fullscreen) window with an OpenGL 4.6 context. Without
+/// Win32 there is no window, the headless backend renders into app.framebuffer on a surfaceless EGL context.
 bool openApp(
     OpenGLApp &app);
 
@@ -230,4 +418,13 @@ bool embedApp(
     long window,
     OpenGLApp &app);
 
+/// Read the app's framebuffer back as tightly packed RGBA8 rows, the bottom row first. Call it before GameLoop presents.
+bool readFramebuffer(
+    const OpenGLApp &app,
+    std::vector<unsigned char> &pixels);
+
+/// Run the app until it is closed, calling Update at a fixed rate and Render once per frame. Returns what Cleanup returns.
+int runApp(
+    OpenGLApp &app);
+
 #endif // OPENGLAPP_HPP
@@ -0,0 +1,87 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// One finished CPU scope, timestamps in nanoseconds of profileNow().
+struct ProfileEvent
+{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+/// A sample of a value that is plotted over time, like the draw calls per frame.
+struct ProfileCounter
+{
+    const char *name;
+    uint64_t time;
+    double value;
+};
+
+struct ProfileThreadEvents
+{
+    uint32_t threadId;
+    std::string threadName;
+    std::vector<ProfileEvent> events;
+    std::vector<ProfileCounter> counters;
+};
+
+/// Nanoseconds on the monotonic clock the profiler stamps its events with.
+uint64_t profileNow();
+
+/// Name the calling thread in the traces.
+void setProfileThreadName(
+    const char *name);
+
+/// Record a finished scope in the calling thread's ring buffer. The name has to outlive the profiler, use string literals.
+void recordProfileEvent(
+    const char *name,
+    uint64_t begin,
+    uint64_t end);
+
+/// Copy the events of all threads that ended at or after since. Every thread keeps its last
+/// 32768 events, older ones are overwritten.
+std::vector<ProfileThreadEvents> collectProfileEvents(
+    uint64_t since = 0);
+
+/// Write events as Chrome trace event JSON, which chrome://tracing and Perfetto open.
+bool writeChromeTrace(
+    const std::string &path,
+    const std::vector<ProfileThreadEvents> &threads);
+
+/// Write everything still in the ring buffers as a Chrome trace.
+bool dumpProfile(
+    const std::string &path);
+
+class ProfileScope
+{
+public:
+    ProfileScope(
+        const char *name)
+        : _name(name), _begin(profileNow())
+    {}
+
+    ~ProfileScope()
+    {
+        recordProfileEvent(_name, _begin, profileNow());
+    }
+
+private:
+    const char *_name;
+    uint64_t _begin;
+};
+
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+
+#ifdef PLAYGROUND_PROFILING
+/// Time the rest of the enclosing block on the CPU. Compiles to nothing without PLAYGROUND_PROFILING.
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif // PROFILER_HPP
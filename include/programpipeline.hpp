@@ -0,0 +1,48 @@
+#ifndef PROGRAMPIPELINE_HPP
+#define PROGRAMPIPELINE_HPP
+
+#include <glad/glad.h>
+
+#include <shader.hpp>
+
+/// Combines separable stage programs (see Shader::compileStage) without linking them together.
+class ProgramPipeline
+{
+public:
+    ProgramPipeline();
+
+    // Owns the pipeline object, a copy would delete it twice
+    ProgramPipeline(
+        const ProgramPipeline &) = delete;
+
+    ProgramPipeline &operator=(
+        const ProgramPipeline &) = delete;
+
+    virtual ~ProgramPipeline();
+
+    GLuint id() const;
+
+    /// Unbinds any monolithic program, which would otherwise take precedence over the pipeline. Stages
+    /// whose program was replaced by a reload are attached again first.
+    void bind() const;
+
+    /// Validate the pipeline against the current state, so call it right before a draw, with the
+    /// vertex array, textures, samplers and images bound. Logs the info log when it is not valid.
+    bool validate() const;
+
+    /// The stages are used by reference, they have to outlive the pipeline.
+    bool setup(
+        const Shader &vertStage,
+        const Shader &fragStage);
+
+private:
+    GLuint _pipelineId = 0;
+    const Shader *_vertStage = nullptr;
+    const Shader *_fragStage = nullptr;
+    mutable GLuint _vertProgram = 0;
+    mutable GLuint _fragProgram = 0;
+
+    void useStages() const;
+};
+
+#endif // PROGRAMPIPELINE_HPP
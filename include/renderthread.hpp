@@ -0,0 +1,81 @@
+#ifndef RENDERTHREAD_HPP
+#define RENDERTHREAD_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct OpenGLApp;
+
+/// Moves the GL context of an OpenGLApp to a thread of its own. The main thread records GL work as
+/// commands, GameLoop hands the list over at the end of the frame and the render thread executes and
+/// presents it while the main thread already records the next frame.
+///
+/// Ownership: objects holding GL names, like Shader and VertextBuffer, belong to the render thread.
+/// Their destructors delete those names, so create them with runAndWait(), use them only from inside
+/// commands and give up the last reference with release(), so that happens where the context is current. The main thread may
+/// hold pointers to them, but never calls into them directly while the render thread runs.
+class RenderThread
+{
+public:
+    typedef std::function<void()> Command;
+
+    RenderThread();
+
+    virtual ~RenderThread();
+
+    /// Release the context on the calling thread and make it current on the render thread.
+    bool start(
+        OpenGLApp &app);
+
+    /// Finish the submitted frame, stop the render thread and make the context current on the calling thread again.
+    void stop();
+
+    bool isRunning() const;
+
+    /// Record a command into the frame that is being built. Main thread only.
+    void submit(
+        Command command);
+
+    /// Run a command on the render thread as soon as it is between frames and wait for it.
+    void runAndWait(
+        Command command);
+
+    /// Drop the reference to an object on the render thread, for objects that delete GL names when destroyed.
+    template <class T>
+    void release(
+        std::shared_ptr<T> object)
+    {
+        submit([object = std::move(object)]() mutable { object.reset(); });
+    }
+
+    /// Called by GameLoop instead of presenting, waits until the render thread is done with the
+    /// previous frame and hands it the commands recorded since.
+    void endFrame();
+
+private:
+    OpenGLApp *_app = nullptr;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::vector<Command> _recording;
+    std::vector<Command> _submitted;
+    std::vector<Command> _immediate;
+    bool _hasFrame = false;
+    bool _started = false;
+    bool _failed = false;
+    bool _stop = false;
+    uint64_t _immediateDone = 0;
+    uint64_t _immediateQueued = 0;
+
+    void run();
+
+    void runImmediate(
+        std::unique_lock<std::mutex> &lock);
+};
+
+#endif // RENDERTHREAD_HPP
@@ -0,0 +1,73 @@
+#ifndef RESOURCELOADER_HPP
+#define RESOURCELOADER_HPP
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct OpenGLApp;
+
+/// Runs uploads on a loader thread with a second GL context that shares objects with the app's
+/// context (see OpenGLApp::backgroundLoading). Every upload is fenced; once the GPU passed the fence,
+/// its ready callback runs on the thread that presents, so streaming large assets never stalls a frame.
+///
+/// Buffers, textures, shaders and programs are shared between the contexts. Container objects like
+/// vertex arrays, framebuffers and program pipelines are not, create those in the ready callback.
+class ResourceLoader
+{
+public:
+    typedef std::function<void()> Task;
+
+    ResourceLoader();
+
+    virtual ~ResourceLoader();
+
+    /// Start the loader thread on the app's loader context.
+    bool start(
+        OpenGLApp &app);
+
+    /// Finish all queued uploads and stop the loader thread. Ready callbacks that did not run yet are dropped.
+    void stop();
+
+    bool isRunning() const;
+
+    /// Queue an upload for the loader thread. Once the GPU finished it, ready runs during a later present.
+    void load(
+        Task upload,
+        Task ready = nullptr);
+
+    /// Called by present on the thread the app's context is current on. Runs the ready callbacks of
+    /// finished uploads and never waits for the GPU.
+    void update();
+
+    /// Uploads that were queued and whose ready callback has not run yet.
+    size_t pendingCount() const;
+
+private:
+    struct Upload
+    {
+        Task upload;
+        Task ready;
+        GLsync fence = nullptr;
+    };
+
+    OpenGLApp *_app = nullptr;
+    std::thread _thread;
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Upload> _queued;
+    std::vector<Upload> _uploaded;
+    size_t _pending = 0;
+    bool _started = false;
+    bool _failed = false;
+    bool _stop = false;
+
+    void run();
+};
+
+#endif // RESOURCELOADER_HPP
@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include <map>
 #include <string>
+#include <variant>
 
 #define GLSL100ES(src) "#version 100 es\n" #src
 #define GLSL300ES(src) "#version 300 es\n" #src
@@ -26,11 +27,48 @@
 #define GLSL450(src) "#version 450\n" #src
 #define GLSL460(src) "#version 460\n" #src
 
+/// Uniform location of a SPIR-V module, SPIR-V programs can not look these up by name.
+struct SpirvUniform
+{
+    const char *name;
+    GLint location;
+};
+
+/// Specialization constant (layout(constant_id = N)) of a SPIR-V module.
+struct SpirvSpecConstant
+{
+    const char *name;
+    GLuint id;
+};
+
+/// A SPIR-V binary with its reflection, as generated by playground_add_spirv_shaders.
+struct SpirvModule
+{
+    GLenum stage;
+    const void *code;
+    GLsizei size;
+    const char *entryPoint;
+    const SpirvUniform *uniforms;
+    size_t uniformCount;
+    const SpirvSpecConstant *constants;
+    size_t constantCount;
+};
+
+/// Specialization constant values by name. Non-integer constants take the bit pattern of their value.
+typedef std::map<std::string, GLuint> SpecializationConstants;
+
 class Shader
 {
 public:
     Shader();
 
+    // Owns its program, a copy would delete it twice
+    Shader(
+        const Shader &) = delete;
+
+    Shader &operator=(
+        const Shader &) = delete;
+
     virtual ~Shader();
 
     GLuint id() const;
@@ -41,6 +79,52 @@ public:
         const std::string &vertShaderStr,
         const std::string &fragShaderStr);
 
+    /// Compile and link a program with a single compute stage.
+    bool compileCompute(
+        const std::string &compShaderStr);
+
+    /// Compile a single stage into a separable program (GL_PROGRAM_SEPARABLE) that is combined with
+    /// other stages through a ProgramPipeline instead of being linked with them. Vertex stages have
+    /// to redeclare the gl_PerVertex output block.
+    bool compileStage(
+        GLenum stage,
+        const std::string &shaderStr);
+
+    /// The GL_*_SHADER_BIT stages a separable program provides, 0 for monolithic programs.
+    GLbitfield stages() const;
+
+    /// Link a program from precompiled SPIR-V (GL_ARB_gl_spirv), specialized with the given constants.
+    bool loadSpirv(
+        const SpirvModule &vertModule,
+        const SpirvModule &fragModule,
+        const SpecializationConstants &constants = SpecializationConstants());
+
+    /// Link a compute program from precompiled SPIR-V, specialized with the given constants.
+    bool loadSpirvCompute(
+        const SpirvModule &compModule,
+        const SpecializationConstants &constants = SpecializationConstants());
+
+    /// Start compiling a replacement program without waiting for the driver to finish, see pollReload.
+    void beginReload(
+        const std::string &vertShaderStr,
+        const std::string &fragShaderStr);
+
+    /// Start compiling a replacement separable program for a single stage, like compileStage does,
+    /// so pipelines using it keep working once it is swapped in.
+    void beginReload(
+        GLenum stage,
+        const std::string &shaderStr);
+
+    /// Check on a reload started with beginReload. Once the driver is done the new program is swapped
+    /// in with all uniform values set so far, or, when it failed to compile, the old program is kept.
+    /// Returns false while the reload is still compiling. A swap changes id(), ProgramPipeline picks
+    /// that up the next time it is bound.
+    bool pollReload();
+
+    /// Drop a reload that is still compiling, deleting its program, and keep the current program.
+    void cancelReload();
+
+    /// Uniforms are set with glProgramUniform*, so the program does not have to be bound.
     void setUniform(
         const char *uniformName,
         const glm::mat4 &m);
@@ -61,12 +145,45 @@ public:
         const char *uniformName,
         float f);
 
+protected:
+    /// Called whenever a compile, load or reload linked a new program, for subclasses that reflect on it.
+    virtual void programChanged();
+
 private:
+    typedef std::variant<std::monostate, int, float, glm::vec3, glm::vec4, glm::mat4> UniformValue;
+
+    /// The last value is kept so it can be restored when the program is replaced by a reload.
+    struct Uniform
+    {
+        GLint location = -1;
+        UniformValue value;
+    };
+
     GLuint _shaderId = 0;
-    std::map<std::string, GLuint> _uniforms;
+    GLbitfield _stages = 0;
+    std::map<std::string, Uniform> _uniforms;
+    GLuint _reloadProgramId = 0;
+    GLbitfield _reloadStages = 0;
+    std::map<GLenum, GLuint> _reloadShaders;
+
+    /// Delete the program, any pending reload and the uniforms before compiling a new one.
+    void deleteProgram();
+
+    void startReload(
+        const std::map<GLenum, std::string> &sources,
+        GLbitfield separableStages);
 
-    GLuint ensureUniformId(
+    Uniform &ensureUniform(
         const char *uniformName);
+
+    void applyUniform(
+        const Uniform &uniform);
+
+    void replaceProgram(
+        GLuint programId);
+
+    void addSpirvUniforms(
+        const SpirvModule &module);
 };
 
 #endif // SHADER_HPP
@@ -0,0 +1,71 @@
+#ifndef SHADERCACHE_HPP
+#define SHADERCACHE_HPP
+
+#include <computeshader.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <programpipeline.hpp>
+#include <shader.hpp>
+#include <shaderpreprocessor.hpp>
+#include <string>
+
+/// Compiles every unique (source, defines) permutation exactly once and hands out shared programs,
+/// so materials that use the same variant share one program object. With separable stages and
+/// pipelines, N vertex and M fragment variants cost N + M compiles instead of N x M links.
+///
+/// Variants are keyed on the preprocessed source, so an edited include gives a new variant instead
+/// of the stale one. That means every lookup preprocesses, keep the program instead of asking each frame.
+class ShaderCache
+{
+public:
+    ShaderCache(
+        ShaderPreprocessor &preprocessor);
+
+    virtual ~ShaderCache();
+
+    /// Get the program for this vertex/fragment pair and define set, compiling it on first use. Returns nullptr when compiling fails.
+    std::shared_ptr<Shader> get(
+        const std::string &vertShaderStr,
+        const std::string &fragShaderStr,
+        const ShaderDefines &defines = ShaderDefines());
+
+    /// Get the compute program for this source and define set, compiling it on first use. Returns nullptr when compiling fails.
+    std::shared_ptr<ComputeShader> getCompute(
+        const std::string &compShaderStr,
+        const ShaderDefines &defines = ShaderDefines());
+
+    /// Get the separable program for a single stage and define set, compiling it on first use. Returns nullptr when compiling fails.
+    std::shared_ptr<Shader> getStage(
+        GLenum stage,
+        const std::string &shaderStr,
+        const ShaderDefines &defines = ShaderDefines());
+
+    /// Get the pipeline combining two separable stages, creating it on first use. Returns nullptr when either
+    /// is not a separable program for its stage.
+    std::shared_ptr<ProgramPipeline> getPipeline(
+        const std::shared_ptr<Shader> &vertStage,
+        const std::shared_ptr<Shader> &fragStage);
+
+    /// Number of programs compiled so far.
+    size_t size() const;
+
+    /// Number of program pipelines created so far.
+    size_t pipelineCount() const;
+
+    /// Drop the cache's references, programs still in use stay alive until released.
+    void clear();
+
+private:
+    typedef std::pair<uint64_t, ShaderDefines> VariantKey;
+
+    ShaderPreprocessor &_preprocessor;
+    std::map<VariantKey, std::shared_ptr<Shader>> _variants;
+    std::map<VariantKey, std::shared_ptr<ComputeShader>> _computeVariants;
+    std::map<std::pair<GLenum, VariantKey>, std::shared_ptr<Shader>> _stageVariants;
+    // Keyed on the stages rather than their program ids, which change on a hot reload. This also
+    // keeps the stages alive for as long as the pipeline that uses them
+    std::map<std::pair<std::shared_ptr<Shader>, std::shared_ptr<Shader>>, std::shared_ptr<ProgramPipeline>> _pipelines;
+};
+
+#endif // SHADERCACHE_HPP
@@ -0,0 +1,72 @@
+#ifndef SHADERPREPROCESSOR_HPP
+#define SHADERPREPROCESSOR_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/// Defines injected into a shader source, name -> value. A std::map keeps them sorted so equal
+/// sets always produce the same source and the same cache key.
+typedef std::map<std::string, std::string> ShaderDefines;
+
+/// Expands #include directives and injects defines into GLSL sources before they reach the driver.
+class ShaderPreprocessor
+{
+public:
+    ShaderPreprocessor();
+
+    virtual ~ShaderPreprocessor();
+
+    /// Add a directory to resolve #include "file" and #include <file> against.
+    void addIncludePath(
+        const std::string &path);
+
+    /// Register an in-memory include file. These take precedence over the include paths.
+    void addInclude(
+        const std::string &name,
+        const std::string &source);
+
+    /// Resolve all includes in source and insert the defines right after the #version line.
+    bool process(
+        const std::string &source,
+        const ShaderDefines &defines,
+        std::string &result);
+
+    /// Same as process, reading the source from a file. Relative includes resolve against its directory
+    /// first. When files is given, it receives the paths of the source and every file it included.
+    bool processFile(
+        const std::string &path,
+        const ShaderDefines &defines,
+        std::string &result,
+        std::vector<std::string> *files = nullptr);
+
+private:
+    std::vector<std::string> _includePaths;
+    std::map<std::string, std::string> _includes;
+
+    bool process(
+        const std::string &source,
+        const std::string &sourcePath,
+        const ShaderDefines &defines,
+        std::string &result,
+        std::vector<std::string> *files);
+
+    bool expandIncludes(
+        const std::string &source,
+        const std::string &sourceDir,
+        int sourceIndex,
+        int firstLine,
+        int depth,
+        std::set<std::string> &onceFiles,
+        std::vector<std::string> &files,
+        std::string &result);
+
+    bool loadInclude(
+        const std::string &name,
+        const std::string &sourceDir,
+        std::string &path,
+        std::string &source);
+};
+
+#endif // SHADERPREPROCESSOR_HPP
@@ -0,0 +1,93 @@
+#ifndef SHADERWATCHER_HPP
+#define SHADERWATCHER_HPP
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shader.hpp>
+#include <shaderpreprocessor.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Hot reload for file-backed shaders. A background thread watches the source files and their
+/// includes (inotify on Linux, polling elsewhere), reads and preprocesses changed sources, and
+/// update() swaps the recompiled programs into the existing Shader objects at a frame boundary.
+class ShaderWatcher
+{
+public:
+    /// The preprocessor is copied, the watcher thread uses it without locking.
+    ShaderWatcher(
+        const ShaderPreprocessor &preprocessor);
+
+    virtual ~ShaderWatcher();
+
+    /// Compile the shader from files and recompile it whenever one of them, or one of their includes, changes.
+    bool watch(
+        Shader &shader,
+        const std::string &vertPath,
+        const std::string &fragPath,
+        const ShaderDefines &defines = ShaderDefines());
+
+    /// Compile a separable stage program (see Shader::compileStage) from a file and recompile it
+    /// whenever the file or one of its includes changes. Pipelines using it pick up the new program.
+    bool watchStage(
+        Shader &shader,
+        GLenum stage,
+        const std::string &path,
+        const ShaderDefines &defines = ShaderDefines());
+
+    /// Stop reloading the shader, this has to be done before it is destroyed. Call it on the thread that
+    /// owns the GL context, a reload that is still compiling is cancelled.
+    void unwatch(
+        Shader &shader);
+
+    /// Call once per frame on the thread that owns the GL context. Starts compiling reloaded sources
+    /// and swaps finished programs in without waiting for the driver.
+    void update();
+
+private:
+    /// Either a vertex and fragment path for a program, or a single path for a separable stage.
+    struct WatchedShader
+    {
+        GLenum stage;
+        std::vector<std::string> paths;
+        ShaderDefines defines;
+        std::set<std::string> files;
+    };
+
+    /// The preprocessed sources, in the order of WatchedShader::paths.
+    struct ReloadedSource
+    {
+        GLenum stage;
+        std::vector<std::string> sources;
+    };
+
+    ShaderPreprocessor _preprocessor;
+    std::mutex _mutex;
+    std::map<Shader *, WatchedShader> _shaders;
+    std::map<Shader *, ReloadedSource> _reloaded;
+    std::set<Shader *> _compiling;
+    std::thread _thread;
+    std::atomic<bool> _stop = false;
+    int _wakeFd = -1;
+
+    bool readSources(
+        const WatchedShader &watched,
+        std::vector<std::string> &sources,
+        std::set<std::string> &files);
+
+    bool watch(
+        Shader &shader,
+        const WatchedShader &watched);
+
+    void watchThread();
+
+    void wakeThread();
+
+    void reloadChangedFiles(
+        const std::set<std::string> &changedFiles);
+};
+
+#endif // SHADERWATCHER_HPP
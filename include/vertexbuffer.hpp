@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 
+#include <profiler.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <vector>
@@ -8,6 +9,28 @@ template <class TVertex>
 class VertextBuffer
 {
 public:
+    VertextBuffer() = default;
+
+    // Owns its vertex array and buffer, a copy would delete them twice
+    VertextBuffer(
+        const VertextBuffer &) = delete;
+
+    VertextBuffer &operator=(
+        const VertextBuffer &) = delete;
+
+    virtual ~VertextBuffer()
+    {
+        if (_vbo != 0)
+        {
+            glDeleteBuffers(1, &_vbo);
+        }
+
+        if (_vao != 0)
+        {
+            glDeleteVertexArrays(1, &_vao);
+        }
+    }
+
     template <
         class TAttr0, unsigned int NAttr0>
     bool setup(
@@ -146,11 +169,27 @@ public:
 
     void upload()
     {
+        PROFILE_SCOPE("VertextBuffer::upload");
+
         bind();
 
         glBufferData(GL_ARRAY_BUFFER, sizeof(TVertex) * _vertices.size(), _vertices.data(), GL_STATIC_DRAW);
     }
 
+    /// Upload the vertices without touching the vertex array, so this can run on a ResourceLoader. Vertex
+    /// arrays are not shared between contexts, call setup() on the presenting context once it is ready.
+    void uploadBuffer()
+    {
+        PROFILE_SCOPE("VertextBuffer::uploadBuffer");
+
+        if (_vbo == 0)
+        {
+            glCreateBuffers(1, &_vbo);
+        }
+
+        glNamedBufferData(_vbo, sizeof(TVertex) * _vertices.size(), _vertices.data(), GL_STATIC_DRAW);
+    }
+
     void resize(
         const size_t size)
     {
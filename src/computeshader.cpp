@@ -0,0 +1,88 @@
+#include <computeshader.hpp>
+
+#include <spdlog/spdlog.h>
+
+void memoryBarrier(
+    MemoryBarriers barriers)
+{
+    if (barriers == MemoryBarrierNone)
+    {
+        return;
+    }
+
+    glMemoryBarrier(static_cast<GLbitfield>(barriers));
+}
+
+ComputeShader::ComputeShader() = default;
+
+ComputeShader::~ComputeShader() = default;
+
+bool ComputeShader::compile(
+    const std::string &compShaderStr)
+{
+    return compileCompute(compShaderStr);
+}
+
+bool ComputeShader::loadSpirv(
+    const SpirvModule &compModule,
+    const SpecializationConstants &constants)
+{
+    return loadSpirvCompute(compModule, constants);
+}
+
+void ComputeShader::programChanged()
+{
+    reflectWorkGroupSize();
+}
+
+void ComputeShader::reflectWorkGroupSize()
+{
+    GLint size[3] = {1, 1, 1};
+    glGetProgramiv(id(), GL_COMPUTE_WORK_GROUP_SIZE, size);
+
+    _workGroupSize = glm::uvec3(size[0], size[1], size[2]);
+
+    spdlog::debug("compute shader work group size is {}x{}x{}", size[0], size[1], size[2]);
+}
+
+const glm::uvec3 &ComputeShader::workGroupSize() const
+{
+    return _workGroupSize;
+}
+
+void ComputeShader::dispatch(
+    GLuint groupsX,
+    GLuint groupsY,
+    GLuint groupsZ)
+{
+    if (groupsX == 0 || groupsY == 0 || groupsZ == 0)
+    {
+        return;
+    }
+
+    bind();
+
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void ComputeShader::dispatchInvocations(
+    GLuint countX,
+    GLuint countY,
+    GLuint countZ)
+{
+    dispatch(
+        (countX + _workGroupSize.x - 1) / _workGroupSize.x,
+        (countY + _workGroupSize.y - 1) / _workGroupSize.y,
+        (countZ + _workGroupSize.z - 1) / _workGroupSize.z);
+}
+
+void ComputeShader::dispatchIndirect(
+    GLuint buffer,
+    GLintptr offset)
+{
+    bind();
+
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer);
+    glDispatchComputeIndirect(offset);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
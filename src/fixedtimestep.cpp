@@ -0,0 +1,105 @@
+#include <fixedtimestep.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <openglapp.hpp>
+#include <profiler.hpp>
+
+FixedTimestep::FixedTimestep(
+    double stepsPerSecond,
+    int maxStepsPerFrame)
+    : _stepTime(1.0 / stepsPerSecond),
+      _maxStepsPerFrame(std::max(maxStepsPerFrame, 1))
+{}
+
+FixedTimestep::~FixedTimestep() = default;
+
+void FixedTimestep::setStepsPerSecond(
+    double stepsPerSecond)
+{
+    _stepTime = 1.0 / stepsPerSecond;
+}
+
+void FixedTimestep::setMaxStepsPerFrame(
+    int maxStepsPerFrame)
+{
+    _maxStepsPerFrame = std::max(maxStepsPerFrame, 1);
+}
+
+double FixedTimestep::stepTime() const
+{
+    return _stepTime;
+}
+
+double FixedTimestep::advance(
+    double frameTime,
+    const std::function<void(double)> &update)
+{
+    _accumulator += std::max(frameTime, 0.0);
+
+    int steps = 0;
+
+    while (_accumulator >= _stepTime && steps < _maxStepsPerFrame)
+    {
+        if (update)
+        {
+            update(_stepTime);
+        }
+
+        _accumulator -= _stepTime;
+        _stepCount++;
+        steps++;
+    }
+
+    // Hit the cap, keep the fraction of a step for interpolation and let the rest go
+    if (_accumulator >= _stepTime)
+    {
+        auto remainder = std::fmod(_accumulator, _stepTime);
+
+        _droppedTime += _accumulator - remainder;
+        _accumulator = remainder;
+    }
+
+    return _accumulator / _stepTime;
+}
+
+uint64_t FixedTimestep::stepCount() const
+{
+    return _stepCount;
+}
+
+double FixedTimestep::droppedTime() const
+{
+    return _droppedTime;
+}
+
+int runApp(
+    OpenGLApp &app)
+{
+    FixedTimestep timestep(app.updateRate, app.maxUpdatesPerFrame);
+
+    while (app.GameLoop())
+    {
+        double alpha;
+
+        {
+            PROFILE_SCOPE("update");
+
+            timestep.setStepsPerSecond(app.updateRate);
+            timestep.setMaxStepsPerFrame(app.maxUpdatesPerFrame);
+
+            auto deltaTime = app.fixedDeltaTime > 0.0 ? app.fixedDeltaTime : app.frameStats.deltaTime();
+
+            alpha = timestep.advance(deltaTime, app.Update);
+        }
+
+        if (app.Render)
+        {
+            PROFILE_SCOPE("render");
+
+            app.Render(alpha);
+        }
+    }
+
+    return app.Cleanup();
+}
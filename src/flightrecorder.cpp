@@ -0,0 +1,215 @@
+#include <flightrecorder.hpp>
+
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+
+// Tracks that are not threads, their ids stay clear of the ones the profiler hands out
+static const uint32_t framesTrackId = 0x10000;
+static const uint32_t gpuTrackId = 0x10001;
+
+// Frames before the rolling median is trusted to detect hitches
+static const uint64_t warmUpFrames = 60;
+
+FlightRecorder::FlightRecorder(
+    size_t maxFrames)
+    : _frames(maxFrames)
+{}
+
+FlightRecorder::~FlightRecorder()
+{
+    if (_pendingDump.valid())
+    {
+        _pendingDump.wait();
+    }
+}
+
+void FlightRecorder::setEnabled(
+    bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool FlightRecorder::isEnabled() const
+{
+    return _enabled;
+}
+
+void FlightRecorder::setHitchThreshold(
+    double factor)
+{
+    _hitchThreshold = factor;
+}
+
+void FlightRecorder::setHistory(
+    double seconds)
+{
+    _history = seconds;
+}
+
+void FlightRecorder::setOutputDirectory(
+    const std::string &directory)
+{
+    _outputDirectory = directory;
+}
+
+void FlightRecorder::recordFrame(
+    const FrameStats &stats,
+    bool gpuTimings)
+{
+    auto now = profileNow();
+
+    if (!_enabled || _frames.empty())
+    {
+        _frameBegin = now;
+
+        return;
+    }
+
+    // The GPU profiler was just asked for the next frame, which may have read back an older one
+    if (gpuTimings)
+    {
+        attachGpuFrame();
+    }
+
+    if (_frameBegin != 0)
+    {
+        auto &frame = _frames[_frameCount % _frames.size()];
+
+        frame.begin = _frameBegin;
+        frame.end = now;
+        frame.deltaTime = stats.deltaTime();
+        frame.cpuTime = stats.cpuTime();
+        frame.swapTime = stats.swapTime();
+        frame.hitch = false;
+        frame.hasGlCalls = glTrace().isEnabled();
+        frame.glCalls = frame.hasGlCalls ? glTrace().lastFrame() : GlCallCounts();
+        frame.gpuFrameIndex = _gpuFrameIndex;
+        frame.hasGpuFrame = _hasGpuFrame;
+        frame.gpuScopeCount = 0;
+
+        _frameCount++;
+
+        auto median = stats.deltaTimeSummary().p50;
+
+        if (_frameCount > warmUpFrames && median > 0.0 && frame.deltaTime > _hitchThreshold * median)
+        {
+            frame.hitch = true;
+
+            spdlog::warn("frame {} took {:.2f} ms, {:.1f}x the median of {:.2f} ms",
+                         _frameCount, frame.deltaTime * 1000.0, frame.deltaTime / median, median * 1000.0);
+
+            // One trace per history window is enough, the next one would mostly repeat this one
+            bool busy = _pendingDump.valid() && _pendingDump.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+
+            if (!busy && !_hitchPending && (_lastDump == 0 || now - _lastDump > static_cast<uint64_t>(_history * 1.0e9)))
+            {
+                _lastDump = now;
+                _hitchPending = true;
+                _hitchFrame = _frameCount;
+                _hitchEnd = now;
+                _hitchHasGpuFrame = frame.hasGpuFrame;
+                _hitchGpuFrameIndex = frame.gpuFrameIndex;
+            }
+        }
+    }
+
+    // The hitch frame's GPU timings are read back a few frames late, or dropped after FrameLatency frames
+    if (_hitchPending && (!_hitchHasGpuFrame || _lastGpuFrameIndex >= _hitchGpuFrameIndex || _frameCount >= _hitchFrame + GpuProfiler::FrameLatency))
+    {
+        _hitchPending = false;
+        _pendingDump = startDump(fmt::format("{}/hitch-{}.json", _outputDirectory, _hitchFrame), _hitchEnd);
+    }
+
+    _frameBegin = now;
+    _hasGpuFrame = gpuTimings && gpuProfiler().isRecording();
+    _gpuFrameIndex = _hasGpuFrame ? gpuProfiler().currentFrameIndex() : 0;
+}
+
+bool FlightRecorder::dump(
+    const std::string &path)
+{
+    return startDump(path, _frameBegin).get();
+}
+
+void FlightRecorder::attachGpuFrame()
+{
+    auto &profiler = gpuProfiler();
+
+    if (profiler.lastFrame().empty() || profiler.lastFrameIndex() == _lastGpuFrameIndex)
+    {
+        return;
+    }
+
+    _lastGpuFrameIndex = profiler.lastFrameIndex();
+
+    // Results lag a few frames behind, look for the frame they were recorded in
+    auto count = std::min<uint64_t>(_frameCount, _frames.size());
+
+    for (uint64_t i = 1; i <= count; i++)
+    {
+        auto &frame = _frames[(_frameCount - i) % _frames.size()];
+
+        if (!frame.hasGpuFrame || frame.gpuFrameIndex != _lastGpuFrameIndex)
+        {
+            continue;
+        }
+
+        auto &scopes = profiler.lastFrame();
+
+        frame.gpuScopeCount = static_cast<int>(std::min<size_t>(scopes.size(), MaxGpuScopes));
+        std::copy(scopes.begin(), scopes.begin() + frame.gpuScopeCount, frame.gpuScopes.begin());
+
+        break;
+    }
+}
+
+std::future<bool> FlightRecorder::startDump(
+    const std::string &path,
+    uint64_t end)
+{
+    auto since = end > static_cast<uint64_t>(_history * 1.0e9) ? end - static_cast<uint64_t>(_history * 1.0e9) : 0;
+
+    // Copy what is needed on this thread, the ring keeps changing while the file is written
+    auto threads = collectProfileEvents(since);
+
+    ProfileThreadEvents frames = {framesTrackId, "frames", {}, {}};
+    ProfileThreadEvents gpu = {gpuTrackId, "gpu", {}, {}};
+
+    auto count = std::min<uint64_t>(_frameCount, _frames.size());
+
+    for (uint64_t i = count; i > 0; i--)
+    {
+        auto &frame = _frames[(_frameCount - i) % _frames.size()];
+
+        if (frame.end < since)
+        {
+            continue;
+        }
+
+        frames.events.push_back({frame.hitch ? "hitch" : "frame", frame.begin, frame.end});
+
+        if (frame.hasGlCalls)
+        {
+            frames.counters.push_back({"gl calls", frame.begin, static_cast<double>(frame.glCalls.total)});
+            frames.counters.push_back({"draw calls", frame.begin, static_cast<double>(frame.glCalls.categories[GlCallCategoryDraw])});
+            frames.counters.push_back({"state changes", frame.begin, static_cast<double>(frame.glCalls.categories[GlCallCategoryState])});
+            frames.counters.push_back({"uploads", frame.begin, static_cast<double>(frame.glCalls.categories[GlCallCategoryUpload])});
+        }
+
+        // GPU timestamps are on their own clock, line the frame scope up with the CPU frame start
+        for (int s = 0; s < frame.gpuScopeCount; s++)
+        {
+            auto &scope = frame.gpuScopes[s];
+            auto begin = frame.begin + static_cast<uint64_t>(scope.start * 1.0e6);
+
+            gpu.events.push_back({scope.name, begin, begin + static_cast<uint64_t>(scope.duration * 1.0e6)});
+        }
+    }
+
+    threads.push_back(std::move(frames));
+    threads.push_back(std::move(gpu));
+
+    return std::async(std::launch::async, [path, threads = std::move(threads)]() {
+        return writeChromeTrace(path, threads);
+    });
+}
@@ -0,0 +1,103 @@
+#include <framelimiter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+FrameLimiter::FrameLimiter() = default;
+
+FrameLimiter::~FrameLimiter()
+{
+    setFrameRate(0.0);
+}
+
+void FrameLimiter::setFrameRate(
+    double frameRate)
+{
+    _frameRate = std::max(frameRate, 0.0);
+    _deadline = Clock::time_point();
+
+#ifdef _WIN32
+    // The default 15.6 ms scheduler tick makes every sleep far too coarse to pace frames with
+    bool highResolution = _frameRate > 0.0;
+
+    if (highResolution != _highResolutionTimer)
+    {
+        if (highResolution)
+        {
+            timeBeginPeriod(1);
+        }
+        else
+        {
+            timeEndPeriod(1);
+        }
+
+        _highResolutionTimer = highResolution;
+    }
+#endif
+}
+
+double FrameLimiter::frameRate() const
+{
+    return _frameRate;
+}
+
+void FrameLimiter::wait()
+{
+    if (_frameRate <= 0.0)
+    {
+        return;
+    }
+
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _frameRate));
+    auto now = Clock::now();
+
+    // Catch up on a late frame, but do not try to make up for a long stall with a burst of frames
+    _deadline += period;
+
+    if (_deadline < now - period || _deadline > now + period)
+    {
+        _deadline = now;
+
+        return;
+    }
+
+    while (std::chrono::duration<double>(_deadline - Clock::now()).count() > _sleepEstimate)
+    {
+        sleep();
+    }
+
+    while (Clock::now() < _deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void FrameLimiter::sleep()
+{
+    auto start = Clock::now();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto observed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Welford's update, the estimate stays one standard deviation above the mean
+    _sleepCount++;
+
+    auto delta = observed - _sleepMean;
+    _sleepMean += delta / _sleepCount;
+    _sleepM2 += delta * (observed - _sleepMean);
+
+    _sleepEstimate = _sleepMean + std::sqrt(_sleepM2 / (_sleepCount - 1));
+
+    // Keep adapting when the system's timer behaviour changes
+    if (_sleepCount > 1000)
+    {
+        _sleepCount = 1;
+        _sleepM2 = 0.0;
+    }
+}
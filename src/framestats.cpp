@@ -0,0 +1,122 @@
+#include <framestats.hpp>
+
+#include <algorithm>
+
+FrameStats::FrameStats(
+    size_t windowSize)
+    : _deltaTimes(std::max<size_t>(windowSize, 1), 0.0),
+      _cpuTimes(std::max<size_t>(windowSize, 1), 0.0),
+      _swapTimes(std::max<size_t>(windowSize, 1), 0.0)
+{}
+
+FrameStats::~FrameStats() = default;
+
+void FrameStats::beginPresent()
+{
+    _presentStart = Clock::now();
+}
+
+void FrameStats::endPresent()
+{
+    _presentEnd = Clock::now();
+}
+
+void FrameStats::beginFrame()
+{
+    auto now = Clock::now();
+
+    if (_frameStart != Clock::time_point())
+    {
+        _deltaTimes[_next] = std::chrono::duration<double>(now - _frameStart).count();
+        _cpuTimes[_next] = std::chrono::duration<double>(_presentStart - _frameStart).count();
+        _swapTimes[_next] = std::chrono::duration<double>(_presentEnd - _presentStart).count();
+
+        _next = (_next + 1) % _deltaTimes.size();
+        _frameCount++;
+    }
+
+    _frameStart = now;
+}
+
+void FrameStats::skipIdle(
+    Clock::duration idle)
+{
+    if (_frameStart != Clock::time_point())
+    {
+        _frameStart += idle;
+        _presentStart += idle;
+        _presentEnd += idle;
+    }
+}
+
+uint64_t FrameStats::frameCount() const
+{
+    return _frameCount;
+}
+
+double FrameStats::deltaTime() const
+{
+    return _deltaTimes[(_next + _deltaTimes.size() - 1) % _deltaTimes.size()];
+}
+
+double FrameStats::cpuTime() const
+{
+    return _cpuTimes[(_next + _cpuTimes.size() - 1) % _cpuTimes.size()];
+}
+
+double FrameStats::swapTime() const
+{
+    return _swapTimes[(_next + _swapTimes.size() - 1) % _swapTimes.size()];
+}
+
+FrameTimeSummary FrameStats::deltaTimeSummary() const
+{
+    return summarize(_deltaTimes);
+}
+
+FrameTimeSummary FrameStats::cpuTimeSummary() const
+{
+    return summarize(_cpuTimes);
+}
+
+FrameTimeSummary FrameStats::swapTimeSummary() const
+{
+    return summarize(_swapTimes);
+}
+
+FrameTimeSummary FrameStats::summarize(
+    const std::vector<double> &times) const
+{
+    FrameTimeSummary summary;
+
+    auto count = static_cast<size_t>(std::min<uint64_t>(_frameCount, times.size()));
+
+    if (count == 0)
+    {
+        return summary;
+    }
+
+    // Until the window is full only the first count entries hold measurements
+    std::vector<double> sorted(times.begin(), times.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (auto time : sorted)
+    {
+        total += time;
+    }
+
+    // Nearest-rank percentiles
+    auto percentile = [&sorted](double p) {
+        auto rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    };
+
+    summary.average = total / count;
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.max = sorted.back();
+
+    return summary;
+}
@@ -0,0 +1,646 @@
+#include <glcapture.hpp>
+
+#include "glloader.hpp"
+
+#include <cstring>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+#ifdef PLAYGROUND_GL_CAPTURE
+#include "glcaptureshims.hpp"
+#endif
+
+static const char captureMagic[4] = {'P', 'G', 'G', 'C'};
+static const uint32_t captureVersion = 1;
+
+// The buffer is written out at the end of every frame, or earlier when a frame makes this many bytes
+static const size_t maxBufferedBytes = 16 << 20;
+
+template <class T>
+static void writeValue(
+    std::ofstream &file,
+    T value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <class T>
+static void appendValue(
+    std::vector<uint8_t> &buffer,
+    T value)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(&value);
+
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+// Pads the buffer so the data that follows starts at a multiple of 8 bytes into the file, the
+// replay loads the file as a whole and passes the data to GL right where it is
+static void alignBuffer(
+    std::vector<uint8_t> &buffer,
+    uint64_t written)
+{
+    buffer.resize(buffer.size() + (8 - (written + buffer.size()) % 8) % 8, 0);
+}
+
+GlCapture::GlCapture() = default;
+
+GlCapture::~GlCapture()
+{
+    stop();
+}
+
+bool GlCapture::start(
+    const std::string &path,
+    int frames,
+    int width,
+    int height,
+    unsigned int framebuffer)
+{
+#ifdef PLAYGROUND_GL_CAPTURE
+    stop();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _file.open(path, std::ios::binary | std::ios::trunc);
+
+    if (!_file.is_open())
+    {
+        spdlog::error("failed to open {} for capturing gl calls", path);
+
+        return false;
+    }
+
+    _file.write(captureMagic, sizeof(captureMagic));
+    writeValue<uint32_t>(_file, captureVersion);
+    writeValue<uint32_t>(_file, static_cast<uint32_t>(width));
+    writeValue<uint32_t>(_file, static_cast<uint32_t>(height));
+    writeValue<uint32_t>(_file, framebuffer);
+    writeValue<uint32_t>(_file, static_cast<uint32_t>(glCaptureFunctionCount));
+
+    for (int i = 0; i < glCaptureFunctionCount; i++)
+    {
+        auto name = std::string_view(glCaptureFunctionNames[i]);
+
+        writeValue<uint16_t>(_file, static_cast<uint16_t>(name.size()));
+        _file.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+
+    _path = path;
+    _written = static_cast<uint64_t>(_file.tellp());
+    _buffer.clear();
+    _frames = frames;
+    _capturedFrames = 0;
+    _calls = 0;
+    _warned.assign(glCaptureFunctionCount, false);
+    _mappings.clear();
+
+    // A lazily loaded function would replace its shim on its first call
+    resolveAllOpenGl();
+
+    _getIntegerv = glad_glGetIntegerv;
+    _getBufferParameteri64v = glad_glGetBufferParameteri64v;
+    _getNamedBufferParameteri64v = glad_glGetNamedBufferParameteri64v;
+
+    installGlCaptureShims();
+
+    _capturing = true;
+
+    spdlog::info("capturing gl calls to {}", path);
+
+    return true;
+#else
+    (void)frames;
+    (void)width;
+    (void)height;
+    (void)framebuffer;
+
+    spdlog::error("capturing gl calls to {} needs the library built with PLAYGROUND_GL_CAPTURE", path);
+
+    return false;
+#endif
+}
+
+void GlCapture::stop()
+{
+#ifdef PLAYGROUND_GL_CAPTURE
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_file.is_open())
+    {
+        return;
+    }
+
+    _capturing = false;
+
+    removeGlCaptureShims();
+
+    flush();
+    _file.close();
+
+    spdlog::info("captured {} gl calls of {} frames, {:.1f} MB, to {}", _calls, _capturedFrames, _written / 1.0e6, _path);
+#endif
+}
+
+bool GlCapture::isCapturing() const
+{
+    return _capturing;
+}
+
+void GlCapture::endFrame()
+{
+    if (!_capturing)
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("GlCapture::endFrame");
+
+    bool done = false;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        appendValue<uint16_t>(_buffer, FrameEnd);
+        flush();
+
+        _capturedFrames++;
+        done = _frames > 0 && _capturedFrames >= _frames;
+    }
+
+    if (done)
+    {
+        stop();
+    }
+}
+
+void GlCapture::mapped(
+    uint64_t key,
+    void *pointer,
+    GLsizeiptr length,
+    bool writable)
+{
+    if (!_capturing)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (pointer != nullptr && writable)
+    {
+        _mappings[key] = {pointer, length};
+    }
+    else
+    {
+        _mappings.erase(key);
+    }
+}
+
+void GlCapture::flushMapped(
+    uint64_t key,
+    GLintptr offset,
+    GLsizeiptr length)
+{
+    if (!_capturing)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (auto mapping = _mappings.find(key); mapping != _mappings.end())
+    {
+        writeMapped(mapping->second, offset, length);
+    }
+}
+
+void GlCapture::unmapping(
+    uint64_t key)
+{
+    if (!_capturing)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (auto mapping = _mappings.find(key); mapping != _mappings.end())
+    {
+        writeMapped(mapping->second, 0, mapping->second.length);
+        _mappings.erase(mapping);
+    }
+}
+
+GLsizeiptr GlCapture::bufferSize(
+    GLenum target)
+{
+    GLint64 size = 0;
+
+    if (_getBufferParameteri64v != nullptr)
+    {
+        _getBufferParameteri64v(target, GL_BUFFER_SIZE, &size);
+    }
+
+    return static_cast<GLsizeiptr>(size);
+}
+
+GLsizeiptr GlCapture::namedBufferSize(
+    GLuint buffer)
+{
+    GLint64 size = 0;
+
+    if (_getNamedBufferParameteri64v != nullptr)
+    {
+        _getNamedBufferParameteri64v(buffer, GL_BUFFER_SIZE, &size);
+    }
+
+    return static_cast<GLsizeiptr>(size);
+}
+
+void GlCapture::writeMapped(
+    const Mapping &mapping,
+    GLintptr offset,
+    GLsizeiptr length)
+{
+    if (offset < 0 || length <= 0 || offset + length > mapping.length)
+    {
+        return;
+    }
+
+    appendValue<uint16_t>(_buffer, MappedWrite);
+    appendValue<uint64_t>(_buffer, reinterpret_cast<uint64_t>(mapping.pointer));
+    appendValue<uint64_t>(_buffer, static_cast<uint64_t>(offset));
+    appendValue<uint64_t>(_buffer, static_cast<uint64_t>(length));
+    alignBuffer(_buffer, _written);
+
+    auto data = static_cast<const uint8_t *>(mapping.pointer) + offset;
+
+    _buffer.insert(_buffer.end(), data, data + length);
+}
+
+void GlCapture::flush()
+{
+    _file.write(reinterpret_cast<const char *>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+    _written += _buffer.size();
+    _buffer.clear();
+}
+
+GlCapture &glCapture()
+{
+    static GlCapture capture;
+
+    return capture;
+}
+
+#ifdef PLAYGROUND_GL_CAPTURE
+struct PixelSize
+{
+    size_t group;
+    size_t element;
+};
+
+static PixelSize pixelSize(
+    GLenum format,
+    GLenum type)
+{
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE_3_3_2:
+        case GL_UNSIGNED_BYTE_2_3_3_REV:
+            return {1, 1};
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_5_6_5_REV:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+        case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+            return {2, 2};
+        case GL_UNSIGNED_INT_8_8_8_8:
+        case GL_UNSIGNED_INT_8_8_8_8_REV:
+        case GL_UNSIGNED_INT_10_10_10_2:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_24_8:
+        case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        case GL_UNSIGNED_INT_5_9_9_9_REV:
+            return {4, 4};
+        case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+            return {8, 8};
+    }
+
+    size_t components = 4;
+
+    switch (format)
+    {
+        case GL_RED:
+        case GL_GREEN:
+        case GL_BLUE:
+        case GL_ALPHA:
+        case GL_RED_INTEGER:
+        case GL_GREEN_INTEGER:
+        case GL_BLUE_INTEGER:
+        case GL_DEPTH_COMPONENT:
+        case GL_STENCIL_INDEX:
+            components = 1;
+            break;
+        case GL_RG:
+        case GL_RG_INTEGER:
+        case GL_DEPTH_STENCIL:
+            components = 2;
+            break;
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGB_INTEGER:
+        case GL_BGR_INTEGER:
+            components = 3;
+            break;
+    }
+
+    size_t element = 4;
+
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:
+            element = 1;
+            break;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT:
+            element = 2;
+            break;
+    }
+
+    return {components * element, element};
+}
+
+GlCaptureRecord::GlCaptureRecord(
+    uint16_t function)
+    : _function(function)
+{
+    auto &capture = glCapture();
+
+    if (!capture._capturing.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    _lock = std::unique_lock<std::mutex>(capture._mutex);
+
+    // Stopped while this call waited for the lock
+    if (!capture._capturing)
+    {
+        _lock.unlock();
+
+        return;
+    }
+
+    _capture = &capture;
+    _capture->_calls++;
+
+    value(function);
+}
+
+GlCaptureRecord::~GlCaptureRecord()
+{
+    if (_capture != nullptr && _capture->_buffer.size() >= maxBufferedBytes)
+    {
+        _capture->flush();
+    }
+}
+
+void GlCaptureRecord::write(
+    const void *data,
+    size_t size)
+{
+    auto bytes = static_cast<const uint8_t *>(data);
+
+    _capture->_buffer.insert(_capture->_buffer.end(), bytes, bytes + size);
+}
+
+void GlCaptureRecord::tag(
+    GlCaptureTags tag)
+{
+    value(static_cast<uint8_t>(tag));
+}
+
+void GlCaptureRecord::sync(
+    GLsync sync)
+{
+    value(reinterpret_cast<uint64_t>(sync));
+}
+
+void GlCaptureRecord::data(
+    const void *data,
+    size_t size)
+{
+    if (data == nullptr)
+    {
+        offset(nullptr);
+
+        return;
+    }
+
+    tag(GlCaptureTagData);
+    value(static_cast<uint64_t>(size));
+    alignBuffer(_capture->_buffer, _capture->_written);
+    write(data, size);
+}
+
+void GlCaptureRecord::string(
+    const GLchar *string,
+    GLint length)
+{
+    if (string == nullptr)
+    {
+        offset(nullptr);
+
+        return;
+    }
+
+    auto size = length >= 0 ? static_cast<size_t>(length) : std::strlen(string);
+
+    tag(GlCaptureTagData);
+    value(static_cast<uint64_t>(size + 1));
+    alignBuffer(_capture->_buffer, _capture->_written);
+    write(string, size);
+    value('\0');
+}
+
+void GlCaptureRecord::strings(
+    GLsizei count,
+    const GLchar *const *strings,
+    const GLint *lengths)
+{
+    if (strings == nullptr)
+    {
+        offset(nullptr);
+
+        return;
+    }
+
+    tag(GlCaptureTagStrings);
+    value(static_cast<uint32_t>(count));
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        auto size = lengths != nullptr && lengths[i] >= 0 ? static_cast<size_t>(lengths[i]) : std::strlen(strings[i]);
+
+        value(static_cast<uint64_t>(size));
+        write(strings[i], size);
+        value('\0');
+    }
+}
+
+void GlCaptureRecord::offset(
+    const void *pointer)
+{
+    tag(GlCaptureTagValue);
+    value(reinterpret_cast<uint64_t>(pointer));
+}
+
+void GlCaptureRecord::output(
+    void *pointer,
+    size_t size)
+{
+    if (pointer == nullptr)
+    {
+        offset(nullptr);
+
+        return;
+    }
+
+    tag(GlCaptureTagOutput);
+    value(static_cast<uint64_t>(size));
+}
+
+void GlCaptureRecord::packOutput(
+    void *pointer,
+    size_t size)
+{
+    if (bufferBound(GL_PIXEL_PACK_BUFFER_BINDING))
+    {
+        offset(pointer);
+    }
+    else
+    {
+        output(pointer, size);
+    }
+}
+
+void GlCaptureRecord::packPixels(
+    void *pixels,
+    GLenum format,
+    GLenum type,
+    GLsizei width,
+    GLsizei height)
+{
+    packOutput(pixels, imageSize(format, type, width, height, 1, true));
+}
+
+void GlCaptureRecord::pixels(
+    const void *pixels,
+    GLenum format,
+    GLenum type,
+    GLsizei width,
+    GLsizei height,
+    GLsizei depth)
+{
+    if (bufferBound(GL_PIXEL_UNPACK_BUFFER_BINDING))
+    {
+        offset(pixels);
+    }
+    else
+    {
+        data(pixels, imageSize(format, type, width, height, depth, false));
+    }
+}
+
+void GlCaptureRecord::unpackData(
+    const void *data,
+    GLsizei size)
+{
+    if (bufferBound(GL_PIXEL_UNPACK_BUFFER_BINDING))
+    {
+        offset(data);
+    }
+    else
+    {
+        this->data(data, static_cast<size_t>(size));
+    }
+}
+
+void GlCaptureRecord::texel(
+    const void *data,
+    GLenum format,
+    GLenum type)
+{
+    this->data(data, pixelSize(format, type).group);
+}
+
+void GlCaptureRecord::unsupported()
+{
+    tag(GlCaptureTagUnsupported);
+
+    if (!_capture->_warned[_function])
+    {
+        _capture->_warned[_function] = true;
+
+        spdlog::warn("{} passes memory of unknown size, the replay skips it", glCaptureFunctionNames[_function]);
+    }
+}
+
+int GlCaptureRecord::parameterCount(
+    GLenum pname)
+{
+    return pname == GL_TEXTURE_BORDER_COLOR || pname == GL_TEXTURE_SWIZZLE_RGBA ? 4 : 1;
+}
+
+bool GlCaptureRecord::bufferBound(
+    GLenum binding) const
+{
+    GLint buffer = 0;
+
+    _capture->_getIntegerv(binding, &buffer);
+
+    return buffer != 0;
+}
+
+size_t GlCaptureRecord::imageSize(
+    GLenum format,
+    GLenum type,
+    GLsizei width,
+    GLsizei height,
+    GLsizei depth,
+    bool pack) const
+{
+    if (width <= 0 || height <= 0 || depth <= 0)
+    {
+        return 0;
+    }
+
+    GLint alignment = 4, rowLength = 0, imageHeight = 0, skipPixels = 0, skipRows = 0, skipImages = 0;
+
+    _capture->_getIntegerv(pack ? GL_PACK_ALIGNMENT : GL_UNPACK_ALIGNMENT, &alignment);
+    _capture->_getIntegerv(pack ? GL_PACK_ROW_LENGTH : GL_UNPACK_ROW_LENGTH, &rowLength);
+    _capture->_getIntegerv(pack ? GL_PACK_IMAGE_HEIGHT : GL_UNPACK_IMAGE_HEIGHT, &imageHeight);
+    _capture->_getIntegerv(pack ? GL_PACK_SKIP_PIXELS : GL_UNPACK_SKIP_PIXELS, &skipPixels);
+    _capture->_getIntegerv(pack ? GL_PACK_SKIP_ROWS : GL_UNPACK_SKIP_ROWS, &skipRows);
+    _capture->_getIntegerv(pack ? GL_PACK_SKIP_IMAGES : GL_UNPACK_SKIP_IMAGES, &skipImages);
+
+    auto size = pixelSize(format, type);
+    auto rowPixels = static_cast<size_t>(rowLength > 0 ? rowLength : width);
+    auto rowBytes = rowPixels * size.group;
+
+    // Rows start at a multiple of the alignment, unless the elements are larger than it
+    if (size.element < static_cast<size_t>(alignment))
+    {
+        rowBytes = (rowBytes + alignment - 1) / alignment * alignment;
+    }
+
+    auto imageBytes = rowBytes * static_cast<size_t>(imageHeight > 0 ? imageHeight : height);
+
+    return (skipImages + depth - 1) * imageBytes + (skipRows + height - 1) * rowBytes + (skipPixels + width) * size.group;
+}
+#endif
@@ -0,0 +1,133 @@
+#ifndef GLCAPTURESHIMS_HPP
+#define GLCAPTURESHIMS_HPP
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <glcapture.hpp>
+#include <mutex>
+
+// Generated by cmake/GenerateGlCapture.cmake, one entry per captured glad function in the order of glad.h
+
+extern const char *const glCaptureFunctionNames[];
+
+extern const int glCaptureFunctionCount;
+
+/// Point every loaded glad function at a shim that forwards the call and captures it.
+void installGlCaptureShims();
+
+/// Point the glad functions back at what they pointed at before installGlCaptureShims.
+void removeGlCaptureShims();
+
+/// Writes one call to glCapture(). The capture is locked from construction to destruction, so the
+/// records of calls from different threads do not interleave. Converts to false when not capturing.
+class GlCaptureRecord
+{
+public:
+    GlCaptureRecord(
+        uint16_t function);
+
+    ~GlCaptureRecord();
+
+    explicit operator bool() const
+    {
+        return _capture != nullptr;
+    }
+
+    template <class T>
+    void value(
+        T value)
+    {
+        write(&value, sizeof(value));
+    }
+
+    void sync(
+        GLsync sync);
+
+    /// Memory of a known size, a null pointer is stored as a value.
+    void data(
+        const void *data,
+        size_t size);
+
+    /// A string of the given length, or up to the terminating 0 when the length is negative.
+    void string(
+        const GLchar *string,
+        GLint length);
+
+    void strings(
+        GLsizei count,
+        const GLchar *const *strings,
+        const GLint *lengths);
+
+    /// An offset into a bound buffer.
+    void offset(
+        const void *pointer);
+
+    void output(
+        void *pointer,
+        size_t size);
+
+    /// Pixels read back to memory, or an offset into the bound pixel pack buffer.
+    void packOutput(
+        void *pointer,
+        size_t size);
+
+    void packPixels(
+        void *pixels,
+        GLenum format,
+        GLenum type,
+        GLsizei width,
+        GLsizei height);
+
+    /// Pixels laid out by the unpack state, or an offset into the bound pixel unpack buffer.
+    void pixels(
+        const void *pixels,
+        GLenum format,
+        GLenum type,
+        GLsizei width,
+        GLsizei height,
+        GLsizei depth);
+
+    /// Compressed pixels, or an offset into the bound pixel unpack buffer.
+    void unpackData(
+        const void *data,
+        GLsizei size);
+
+    /// One pixel, like the clear value of glClearBufferData.
+    void texel(
+        const void *data,
+        GLenum format,
+        GLenum type);
+
+    /// Memory of unknown size, logged the first time a function passes it.
+    void unsupported();
+
+    /// Values a vector texture or sampler parameter has.
+    static int parameterCount(
+        GLenum pname);
+
+private:
+    GlCapture *_capture = nullptr;
+    std::unique_lock<std::mutex> _lock;
+    uint16_t _function;
+
+    void write(
+        const void *data,
+        size_t size);
+
+    void tag(
+        GlCaptureTags tag);
+
+    bool bufferBound(
+        GLenum binding) const;
+
+    size_t imageSize(
+        GLenum format,
+        GLenum type,
+        GLsizei width,
+        GLsizei height,
+        GLsizei depth,
+        bool pack) const;
+};
+
+#endif // GLCAPTURESHIMS_HPP
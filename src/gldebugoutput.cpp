@@ -0,0 +1,455 @@
+#include "gldebugoutput.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <thread>
+
+// Set by the PLAYGROUND_GL_DEBUG cache variable
+#ifndef PLAYGROUND_GL_DEBUG_MODE
+#define PLAYGROUND_GL_DEBUG_MODE DebugOutputAsync
+#endif
+
+struct DebugMessage
+{
+    static constexpr size_t MaxLength = 512;
+
+    GLenum source = 0;
+    GLenum type = 0;
+    GLuint id = 0;
+    GLenum severity = 0;
+    char text[MaxLength] = {0};
+};
+
+static const char *sourceName(
+    GLenum source)
+{
+    switch (source)
+    {
+        case GL_DEBUG_SOURCE_API:
+            return "api";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+            return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER:
+            return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:
+            return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION:
+            return "application";
+    }
+
+    return "other";
+}
+
+static const char *typeName(
+    GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR:
+            return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+            return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+            return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY:
+            return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:
+            return "performance";
+        case GL_DEBUG_TYPE_MARKER:
+            return "marker";
+    }
+
+    return "other";
+}
+
+static void logMessage(
+    const DebugMessage &message)
+{
+    auto level = spdlog::level::debug;
+
+    switch (message.severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH:
+            level = spdlog::level::critical;
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            level = spdlog::level::err;
+            break;
+        case GL_DEBUG_SEVERITY_LOW:
+            level = spdlog::level::warn;
+            break;
+        case GL_DEBUG_SEVERITY_NOTIFICATION:
+            level = spdlog::level::trace;
+            break;
+    }
+
+    spdlog::log(level, "gl {} {} {:#x} - {}", sourceName(message.source), typeName(message.type), message.id, message.text);
+}
+
+// Counts every (source, type, id) in a lock-free hash table, so the first occurrence of a message is
+// logged and the repeats only show up in a summary. Messages go to the log thread through a bounded
+// lock-free queue, the driver thread that raised them never waits for a lock or for the log.
+class DebugOutput
+{
+public:
+    static constexpr size_t QueueCapacity = 256;
+    static constexpr size_t CounterSlots = 1024;
+    static constexpr uint64_t MaxMessagesPerSecond = 20;
+
+    DebugOutput()
+    {
+        for (size_t i = 0; i < QueueCapacity; i++)
+        {
+            _queue[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~DebugOutput()
+    {
+        stop();
+    }
+
+    /// Start the log thread, when it is not running yet.
+    void start()
+    {
+        if (_thread.joinable())
+        {
+            return;
+        }
+
+        _stop = false;
+        _thread = std::thread(&DebugOutput::run, this);
+    }
+
+    /// Log what is still queued and join the log thread. Nothing may push messages anymore.
+    void stop()
+    {
+        if (!_thread.joinable())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _stop = true;
+        }
+
+        _condition.notify_all();
+        _thread.join();
+    }
+
+    /// Count an occurrence of a message, returns true for the first one.
+    bool count(
+        GLenum source,
+        GLenum type,
+        GLuint id)
+    {
+        // Source and type enums are below 0x10000, so the key is unique and never 0
+        auto key = (static_cast<uint64_t>(source & 0xffff) << 48) | (static_cast<uint64_t>(type & 0xffff) << 32) | id;
+        auto slot = static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32);
+
+        for (size_t probe = 0; probe < CounterSlots; probe++)
+        {
+            auto &counter = _counters[(slot + probe) % CounterSlots];
+            auto current = counter.key.load(std::memory_order_acquire);
+
+            if (current == 0)
+            {
+                counter.key.compare_exchange_strong(current, key, std::memory_order_acq_rel);
+
+                // Either this thread claimed the slot or current now holds the key that did
+                current = counter.key.load(std::memory_order_acquire);
+            }
+
+            if (current == key)
+            {
+                return counter.count.fetch_add(1, std::memory_order_relaxed) == 0;
+            }
+        }
+
+        // The table is full, log it every time and leave it to the rate limit
+        return true;
+    }
+
+    /// Queue a message for the log thread, it is dropped and counted when the queue is full.
+    void push(
+        const DebugMessage &message)
+    {
+        auto position = _enqueuePosition.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto &cell = _queue[position % QueueCapacity];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0)
+            {
+                if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.message = message;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+
+                    return;
+                }
+            }
+            else if (difference < 0)
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+
+                return;
+            }
+            else
+            {
+                position = _enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence = 0;
+        DebugMessage message;
+    };
+
+    struct Counter
+    {
+        std::atomic<uint64_t> key = 0;
+        std::atomic<uint32_t> count = 0;
+        uint32_t reported = 1;
+    };
+
+    std::array<Cell, QueueCapacity> _queue;
+    std::atomic<size_t> _enqueuePosition = 0;
+    size_t _dequeuePosition = 0;
+    std::array<Counter, CounterSlots> _counters;
+    std::atomic<uint64_t> _dropped = 0;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stop = false;
+
+    bool pop(
+        DebugMessage &message)
+    {
+        auto &cell = _queue[_dequeuePosition % QueueCapacity];
+
+        if (cell.sequence.load(std::memory_order_acquire) != _dequeuePosition + 1)
+        {
+            return false;
+        }
+
+        message = cell.message;
+        cell.sequence.store(_dequeuePosition + QueueCapacity, std::memory_order_release);
+        _dequeuePosition++;
+
+        return true;
+    }
+
+    void reportRepeats()
+    {
+        for (auto &counter : _counters)
+        {
+            auto key = counter.key.load(std::memory_order_acquire);
+            auto count = counter.count.load(std::memory_order_relaxed);
+
+            if (key == 0 || count <= counter.reported)
+            {
+                continue;
+            }
+
+            spdlog::debug("gl {} {} {:#x} repeated {} times",
+                          sourceName(static_cast<GLenum>(key >> 48)), typeName(static_cast<GLenum>((key >> 32) & 0xffff)),
+                          static_cast<GLuint>(key), count - counter.reported);
+
+            counter.reported = count;
+        }
+    }
+
+    void run()
+    {
+        setProfileThreadName("gl debug");
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto windowStart = std::chrono::steady_clock::now();
+        uint64_t logged = 0;
+        uint64_t suppressed = 0;
+
+        while (true)
+        {
+            _condition.wait_for(lock, std::chrono::milliseconds(100), [this]() { return _stop; });
+
+            DebugMessage message;
+
+            while (pop(message))
+            {
+                if (logged < MaxMessagesPerSecond)
+                {
+                    logMessage(message);
+                    logged++;
+                }
+                else
+                {
+                    suppressed++;
+                }
+            }
+
+            auto now = std::chrono::steady_clock::now();
+
+            if (now - windowStart >= std::chrono::seconds(1) || _stop)
+            {
+                reportRepeats();
+
+                if (suppressed > 0)
+                {
+                    spdlog::warn("{} gl debug messages over the limit of {} per second were not logged", suppressed, MaxMessagesPerSecond);
+                }
+
+                if (auto dropped = _dropped.exchange(0, std::memory_order_relaxed); dropped > 0)
+                {
+                    spdlog::warn("{} gl debug messages were dropped, the queue was full", dropped);
+                }
+
+                windowStart = now;
+                logged = 0;
+                suppressed = 0;
+            }
+
+            if (_stop)
+            {
+                break;
+            }
+        }
+    }
+};
+
+static DebugOutput &debugOutput()
+{
+    static DebugOutput output;
+
+    return output;
+}
+
+static void GLAPIENTRY debugMessageCallback(
+    GLenum source,
+    GLenum type,
+    GLuint id,
+    GLenum severity,
+    GLsizei length,
+    const GLchar *message,
+    const void *userParam)
+{
+    auto &output = debugOutput();
+
+    if (!output.count(source, type, id))
+    {
+        return;
+    }
+
+    DebugMessage entry;
+    entry.source = source;
+    entry.type = type;
+    entry.id = id;
+    entry.severity = severity;
+
+    auto size = std::min<size_t>(length >= 0 ? static_cast<size_t>(length) : std::strlen(message), DebugMessage::MaxLength - 1);
+    std::memcpy(entry.text, message, size);
+    entry.text[size] = '\0';
+
+    // userParam is only set for synchronous output, which logs right in the call that raised the message
+    if (userParam != nullptr)
+    {
+        logMessage(entry);
+    }
+    else
+    {
+        output.push(entry);
+    }
+}
+
+static DebugOutputModes resolveMode(
+    DebugOutputModes mode)
+{
+    if (mode != DebugOutputDefault)
+    {
+        return mode;
+    }
+
+    if (auto value = std::getenv("PLAYGROUND_GL_DEBUG"); value != nullptr)
+    {
+        std::string_view name(value);
+
+        if (name == "off") return DebugOutputOff;
+        if (name == "async") return DebugOutputAsync;
+        if (name == "sync") return DebugOutputSync;
+
+        spdlog::warn("unknown PLAYGROUND_GL_DEBUG value {}, expected off, async or sync", name);
+    }
+
+    return PLAYGROUND_GL_DEBUG_MODE;
+}
+
+void enableOpenGlDebug(
+    DebugOutputModes mode)
+{
+    static const bool synchronous = true;
+
+    mode = resolveMode(mode);
+
+    if (mode == DebugOutputOff)
+    {
+        glDisable(GL_DEBUG_OUTPUT);
+
+        return;
+    }
+
+    // Start the log thread before the first message can arrive
+    debugOutput().start();
+
+    glEnable(GL_DEBUG_OUTPUT);
+
+    if (mode == DebugOutputSync)
+    {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    else
+    {
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+
+    glDebugMessageCallback(debugMessageCallback, mode == DebugOutputSync ? &synchronous : nullptr);
+
+    // Notifications are only logged at trace level, without it they would just be counted and dropped
+    glDebugMessageControl(
+        GL_DONT_CARE,
+        GL_DONT_CARE,
+        GL_DEBUG_SEVERITY_NOTIFICATION,
+        0,
+        NULL,
+        spdlog::should_log(spdlog::level::trace) ? GL_TRUE : GL_FALSE);
+}
+
+void shutdownOpenGlDebug()
+{
+    // The output is a static that outlives the context, with the callback still set an asynchronous
+    // driver thread could call into it while it is being destroyed
+    glDebugMessageCallback(nullptr, nullptr);
+    glDisable(GL_DEBUG_OUTPUT);
+
+    debugOutput().stop();
+}
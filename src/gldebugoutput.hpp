@@ -0,0 +1,15 @@
+#ifndef GLDEBUGOUTPUT_HPP
+#define GLDEBUGOUTPUT_HPP
+
+#include <openglapp.hpp>
+
+/// Route GL debug output of the current context to spdlog. All contexts share one log thread and one
+/// table of the messages seen so far, a message is logged the first time and afterwards only counted.
+void enableOpenGlDebug(
+    DebugOutputModes mode);
+
+/// Unset the debug callback of the current context and stop the log thread, called by Cleanup while
+/// the context is still current. enableOpenGlDebug starts it again.
+void shutdownOpenGlDebug();
+
+#endif // GLDEBUGOUTPUT_HPP
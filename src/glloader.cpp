@@ -0,0 +1,73 @@
+#include "glloader.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+
+#ifdef PLAYGROUND_LAZY_GL_LOADER
+// Generated by cmake/GenerateGlLoader.cmake
+extern "C" int gladLoadGLLazy(GLADloadproc load);
+extern "C" int gladLazyResolvedCount(void);
+extern "C" int gladLazyFunctionCount(void);
+extern "C" void gladLazyResolveAll(void);
+
+static GLADloadproc lazyLoad = nullptr;
+static std::atomic<uint64_t> lazyLoadTime = 0;
+
+static void *timedLoad(
+    const char *name)
+{
+    auto start = profileNow();
+    auto function = lazyLoad(name);
+
+    lazyLoadTime += profileNow() - start;
+
+    return function;
+}
+#endif
+
+bool loadOpenGl(
+    GLADloadproc load)
+{
+    PROFILE_SCOPE("loadOpenGl");
+
+    auto start = profileNow();
+
+#ifdef PLAYGROUND_LAZY_GL_LOADER
+    lazyLoad = load;
+    lazyLoadTime = 0;
+
+    if (!gladLoadGLLazy(timedLoad))
+    {
+        return false;
+    }
+
+    spdlog::info("prepared {} gl functions for loading on first use in {:.3f} ms",
+                 gladLazyFunctionCount(), (profileNow() - start) / 1.0e6);
+#else
+    if (!gladLoadGLLoader(load))
+    {
+        return false;
+    }
+
+    spdlog::info("loaded gl functions in {:.3f} ms", (profileNow() - start) / 1.0e6);
+#endif
+
+    return true;
+}
+
+void logOpenGlLoaderStats()
+{
+#ifdef PLAYGROUND_LAZY_GL_LOADER
+    spdlog::info("loaded {} of {} gl functions on first use in {:.3f} ms",
+                 gladLazyResolvedCount(), gladLazyFunctionCount(), lazyLoadTime / 1.0e6);
+#endif
+}
+
+void resolveAllOpenGl()
+{
+#ifdef PLAYGROUND_LAZY_GL_LOADER
+    gladLazyResolveAll();
+#endif
+}
@@ -0,0 +1,19 @@
+#ifndef GLLOADER_HPP
+#define GLLOADER_HPP
+
+#include <glad/glad.h>
+
+/// Load the GL functions of the current context and log how long it took. With PLAYGROUND_LAZY_GL_LOADER
+/// only the version and extensions are queried and every function is resolved on its first call, so
+/// load has to stay valid while the app runs.
+bool loadOpenGl(
+    GLADloadproc load);
+
+/// Log how many GL functions were resolved on first use and the time that took, with PLAYGROUND_LAZY_GL_LOADER.
+void logOpenGlLoaderStats();
+
+/// Resolve the GL functions that were not called yet, for layers that wrap the glad function table.
+/// Does nothing without PLAYGROUND_LAZY_GL_LOADER, where everything is resolved at load time.
+void resolveAllOpenGl();
+
+#endif // GLLOADER_HPP
@@ -0,0 +1,500 @@
+#include "glreplay.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+static const char captureMagic[4] = {'P', 'G', 'G', 'C'};
+static const uint32_t captureVersion = 1;
+
+// Outputs of unknown size get this much room, enough for any query and most read backs
+static const size_t unknownOutputSize = 16 << 20;
+
+GlReplay::GlReplay() = default;
+
+GlReplay::~GlReplay()
+{
+    if (_timerQueries[0] != 0)
+    {
+        glDeleteQueries(2, _timerQueries);
+    }
+}
+
+bool GlReplay::load(
+    const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+        spdlog::error("failed to open gl capture {}", path);
+
+        return false;
+    }
+
+    _data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(_data.data()), static_cast<std::streamsize>(_data.size()));
+
+    _position = 0;
+    _truncated = false;
+
+    auto magic = read(sizeof(captureMagic));
+
+    if (magic == nullptr || std::memcmp(magic, captureMagic, sizeof(captureMagic)) != 0 || value<uint32_t>() != captureVersion)
+    {
+        spdlog::error("{} is not a gl capture of version {}", path, captureVersion);
+
+        return false;
+    }
+
+    _width = static_cast<int>(value<uint32_t>());
+    _height = static_cast<int>(value<uint32_t>());
+    _capturedFramebuffer = value<uint32_t>();
+
+    auto count = value<uint32_t>();
+
+    std::unordered_map<std::string_view, const GlReplayFunction *> functions;
+
+    for (int i = 0; i < glReplayFunctionCount; i++)
+    {
+        functions[glReplayFunctions[i].name] = &glReplayFunctions[i];
+    }
+
+    _functions.assign(count, nullptr);
+    _warned.assign(count, false);
+
+    for (uint32_t i = 0; i < count && !_truncated; i++)
+    {
+        auto length = value<uint16_t>();
+        auto name = read(length);
+
+        if (name == nullptr)
+        {
+            break;
+        }
+
+        // Records are not self describing, a call this build can not read ends the replay
+        auto function = functions.find(std::string_view(reinterpret_cast<const char *>(name), length));
+
+        if (function == functions.end())
+        {
+            spdlog::error("{} captured {}, which this build does not have", path, std::string_view(reinterpret_cast<const char *>(name), length));
+
+            return false;
+        }
+
+        _functions[i] = function->second;
+    }
+
+    if (_truncated)
+    {
+        spdlog::error("{} is truncated", path);
+
+        return false;
+    }
+
+    _frameStart = _position;
+
+    spdlog::info("loaded gl capture {} of {}x{}, {:.1f} MB", path, _width, _height, _data.size() / 1.0e6);
+
+    return true;
+}
+
+int GlReplay::width() const
+{
+    return _width;
+}
+
+int GlReplay::height() const
+{
+    return _height;
+}
+
+void GlReplay::setFramebuffer(
+    GLuint framebuffer)
+{
+    _names[GlNameFramebuffer][0] = framebuffer;
+    _names[GlNameFramebuffer][_capturedFramebuffer] = framebuffer;
+}
+
+bool GlReplay::replayFrame(
+    GlReplayFrame &frame)
+{
+    if (_truncated || _position >= _data.size())
+    {
+        return false;
+    }
+
+    if (_timerQueries[0] == 0)
+    {
+        glGenQueries(2, _timerQueries);
+    }
+
+    frame = GlReplayFrame();
+    _frameStart = _position;
+    _skipped = 0;
+
+    glQueryCounter(_timerQueries[0], GL_TIMESTAMP);
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!_truncated && _position < _data.size())
+    {
+        auto function = value<uint16_t>();
+
+        if (function == GlCapture::FrameEnd)
+        {
+            break;
+        }
+
+        if (function == GlCapture::MappedWrite)
+        {
+            writeMapped();
+
+            continue;
+        }
+
+        if (function >= _functions.size())
+        {
+            spdlog::error("gl capture has a call to function {}, which it has no name for", function);
+
+            _truncated = true;
+
+            break;
+        }
+
+        _function = function;
+        _callable = true;
+        _usedOutputs = 0;
+
+        _functions[function]->replay(*this);
+
+        frame.calls++;
+    }
+
+    frame.cpuTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    glQueryCounter(_timerQueries[1], GL_TIMESTAMP);
+
+    GLuint64 begin = 0, end = 0;
+
+    glGetQueryObjectui64v(_timerQueries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(_timerQueries[1], GL_QUERY_RESULT, &end);
+
+    frame.gpuTime = (end - begin) / 1.0e9;
+    frame.skipped = _skipped;
+
+    if (_truncated)
+    {
+        spdlog::error("gl capture is truncated, the last frame is incomplete");
+
+        return false;
+    }
+
+    return true;
+}
+
+void GlReplay::repeatFrame()
+{
+    _position = _frameStart;
+}
+
+void *GlReplay::pointer()
+{
+    switch (value<uint8_t>())
+    {
+        case GlCaptureTagValue:
+            return reinterpret_cast<void *>(static_cast<uintptr_t>(value<uint64_t>()));
+        case GlCaptureTagData:
+        {
+            auto size = value<uint64_t>();
+
+            align();
+
+            return const_cast<uint8_t *>(read(size));
+        }
+        case GlCaptureTagOutput:
+            return output(value<uint64_t>());
+        case GlCaptureTagUnsupported:
+            _callable = false;
+
+            return nullptr;
+    }
+
+    _truncated = true;
+
+    return nullptr;
+}
+
+const GLchar *const *GlReplay::strings()
+{
+    auto tag = value<uint8_t>();
+
+    if (tag == GlCaptureTagValue)
+    {
+        return reinterpret_cast<const GLchar *const *>(static_cast<uintptr_t>(value<uint64_t>()));
+    }
+
+    if (tag != GlCaptureTagStrings)
+    {
+        _truncated = true;
+
+        return nullptr;
+    }
+
+    auto count = value<uint32_t>();
+
+    _strings.clear();
+
+    for (uint32_t i = 0; i < count && !_truncated; i++)
+    {
+        auto length = value<uint64_t>();
+
+        _strings.push_back(reinterpret_cast<const GLchar *>(read(length + 1)));
+    }
+
+    return _strings.data();
+}
+
+GLsync GlReplay::sync()
+{
+    auto captured = value<uint64_t>();
+
+    if (captured == 0)
+    {
+        return nullptr;
+    }
+
+    auto sync = _syncs.find(captured);
+
+    if (sync == _syncs.end())
+    {
+        _callable = false;
+
+        return nullptr;
+    }
+
+    return sync->second;
+}
+
+GLuint GlReplay::name(
+    GlNameSpaces space,
+    GLuint captured) const
+{
+    auto name = _names[space].find(captured);
+
+    // Names the capture did not see being created, like the default objects, stay as they are
+    return name != _names[space].end() ? name->second : captured;
+}
+
+const GLuint *GlReplay::names(
+    GlNameSpaces space)
+{
+    auto tag = value<uint8_t>();
+
+    if (tag == GlCaptureTagValue)
+    {
+        return reinterpret_cast<const GLuint *>(static_cast<uintptr_t>(value<uint64_t>()));
+    }
+
+    if (tag != GlCaptureTagData)
+    {
+        _truncated = true;
+
+        return nullptr;
+    }
+
+    auto size = value<uint64_t>();
+
+    align();
+
+    auto captured = reinterpret_cast<const GLuint *>(read(size));
+
+    if (captured == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto names = reinterpret_cast<GLuint *>(output(size));
+
+    for (size_t i = 0; i < size / sizeof(GLuint); i++)
+    {
+        names[i] = name(space, captured[i]);
+    }
+
+    return names;
+}
+
+GLint GlReplay::location(
+    GLuint program,
+    GLint captured) const
+{
+    if (captured < 0)
+    {
+        return captured;
+    }
+
+    auto location = _locations.find((uint64_t(program) << 32) | static_cast<uint32_t>(captured));
+
+    // Explicit locations from layout(location = n) are never queried
+    return location != _locations.end() ? location->second : captured;
+}
+
+GLuint GlReplay::currentProgram() const
+{
+    return _program;
+}
+
+void GlReplay::useProgram(
+    GLuint program)
+{
+    _program = program;
+}
+
+void GlReplay::mapName(
+    GlNameSpaces space,
+    GLuint captured,
+    GLuint name)
+{
+    _names[space][captured] = name;
+}
+
+void GlReplay::mapNames(
+    GlNameSpaces space,
+    const GLuint *captured,
+    const GLuint *names,
+    GLsizei count)
+{
+    if (captured == nullptr)
+    {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        _names[space][captured[i]] = names[i];
+    }
+}
+
+void GlReplay::mapSync(
+    uint64_t captured,
+    GLsync sync)
+{
+    _syncs[captured] = sync;
+}
+
+void GlReplay::deleteSync(
+    GLsync sync)
+{
+    std::erase_if(_syncs, [sync](const auto &mapped) { return mapped.second == sync; });
+}
+
+void GlReplay::mapLocation(
+    GLuint program,
+    GLint captured,
+    GLint location)
+{
+    if (captured >= 0)
+    {
+        _locations[(uint64_t(program) << 32) | static_cast<uint32_t>(captured)] = location;
+    }
+}
+
+void GlReplay::mapPointer(
+    uint64_t captured,
+    void *pointer)
+{
+    if (pointer != nullptr)
+    {
+        _pointers[captured] = static_cast<uint8_t *>(pointer);
+    }
+    else
+    {
+        _pointers.erase(captured);
+    }
+}
+
+bool GlReplay::callable() const
+{
+    return _callable;
+}
+
+void GlReplay::skip()
+{
+    _skipped++;
+
+    if (!_warned[_function])
+    {
+        _warned[_function] = true;
+
+        spdlog::warn("skipping {}, it passes memory of unknown size or a sync that no longer exists", _functions[_function]->name);
+    }
+}
+
+const uint8_t *GlReplay::read(
+    size_t size)
+{
+    if (_truncated || size > _data.size() - _position)
+    {
+        _truncated = true;
+
+        return nullptr;
+    }
+
+    auto data = _data.data() + _position;
+
+    _position += size;
+
+    return data;
+}
+
+void GlReplay::align()
+{
+    _position += (8 - _position % 8) % 8;
+}
+
+uint8_t *GlReplay::output(
+    size_t size)
+{
+    if (_usedOutputs == _outputs.size())
+    {
+        _outputs.emplace_back();
+    }
+
+    auto &output = _outputs[_usedOutputs++];
+
+    if (size == 0)
+    {
+        size = unknownOutputSize;
+    }
+
+    if (output.size() < size)
+    {
+        output.resize(size);
+    }
+
+    return output.data();
+}
+
+void GlReplay::writeMapped()
+{
+    auto captured = value<uint64_t>();
+    auto offset = value<uint64_t>();
+    auto length = value<uint64_t>();
+
+    align();
+
+    auto data = read(length);
+
+    if (data == nullptr)
+    {
+        return;
+    }
+
+    if (auto pointer = _pointers.find(captured); pointer != _pointers.end())
+    {
+        std::memcpy(pointer->second + offset, data, length);
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef GLREPLAY_HPP
+#define GLREPLAY_HPP
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <glcapture.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// The kinds of object names a replay maps from the ones the captured app got to the ones it gets.
+enum GlNameSpaces
+{
+    GlNameBuffer = 0,
+    GlNameTexture,
+    GlNameFramebuffer,
+    GlNameRenderbuffer,
+    GlNameVertexArray,
+    GlNameSampler,
+    GlNameProgramPipeline,
+    GlNameProgram, // Shaders and programs share their names
+    GlNameTransformFeedback,
+    GlNameQuery,
+    GlNameSpaceCount,
+};
+
+class GlReplay;
+
+// Generated by cmake/GenerateGlCapture.cmake, one entry per captured glad function in the order of glad.h
+
+struct GlReplayFunction
+{
+    const char *name;
+    void (*replay)(GlReplay &);
+};
+
+extern const GlReplayFunction glReplayFunctions[];
+
+extern const int glReplayFunctionCount;
+
+/// What replaying one frame took.
+struct GlReplayFrame
+{
+    uint64_t calls = 0;
+    uint64_t skipped = 0;
+    double cpuTime = 0.0; // Seconds to issue the calls
+    double gpuTime = 0.0; // Seconds between GPU timestamps before the first and after the last call
+};
+
+/// Re-issues the calls of a capture GlCapture wrote, frame by frame, on the current context. The whole
+/// file is loaded up front so the data calls pass is handed to GL right where it was read. Object
+/// names, syncs, uniform locations and mapped pointers are mapped to the ones this context hands out,
+/// the framebuffer the app rendered to is replaced by the one the replay renders to. Calls that pass
+/// memory of unknown size, or syncs that do not exist, are skipped.
+class GlReplay
+{
+public:
+    GlReplay();
+
+    virtual ~GlReplay();
+
+    /// Read a capture, fails when it is not one or was made by a build with functions this one does not have.
+    bool load(
+        const std::string &path);
+
+    /// The size of the framebuffer the app rendered to.
+    int width() const;
+
+    int height() const;
+
+    /// Render what went to the app's framebuffer, or the window's, to framebuffer instead.
+    void setFramebuffer(
+        GLuint framebuffer);
+
+    /// Re-issue the calls of the next frame and wait for the GPU to finish them. Returns false at the
+    /// end of the capture or when it is truncated.
+    bool replayFrame(
+        GlReplayFrame &frame);
+
+    /// Make the next replayFrame replay the frame the last one did again, for stable timings.
+    void repeatFrame();
+
+    /// Called by the generated replay functions to read the call's parameters back.
+    template <class T>
+    T value()
+    {
+        T result{};
+
+        if (auto data = read(sizeof(T)); data != nullptr)
+        {
+            std::memcpy(&result, data, sizeof(T));
+        }
+
+        return result;
+    }
+
+    /// A pointer parameter: the offset or data it pointed at, or room for what the call writes.
+    void *pointer();
+
+    const GLchar *const *strings();
+
+    GLsync sync();
+
+    GLuint name(
+        GlNameSpaces space,
+        GLuint captured) const;
+
+    /// An array of object names, mapped.
+    const GLuint *names(
+        GlNameSpaces space);
+
+    GLint location(
+        GLuint program,
+        GLint captured) const;
+
+    GLuint currentProgram() const;
+
+    void useProgram(
+        GLuint program);
+
+    void mapName(
+        GlNameSpaces space,
+        GLuint captured,
+        GLuint name);
+
+    void mapNames(
+        GlNameSpaces space,
+        const GLuint *captured,
+        const GLuint *names,
+        GLsizei count);
+
+    void mapSync(
+        uint64_t captured,
+        GLsync sync);
+
+    /// Forget a deleted sync, so a repeated frame skips waiting for it.
+    void deleteSync(
+        GLsync sync);
+
+    void mapLocation(
+        GLuint program,
+        GLint captured,
+        GLint location);
+
+    void mapPointer(
+        uint64_t captured,
+        void *pointer);
+
+    /// False when a parameter of the current call can not be replayed.
+    bool callable() const;
+
+    /// Called instead of the current call when it is not callable, logged the first time a function is skipped.
+    void skip();
+
+private:
+    std::vector<uint8_t> _data;
+    size_t _position = 0;
+    size_t _frameStart = 0;
+    bool _truncated = false;
+    int _width = 0;
+    int _height = 0;
+    GLuint _capturedFramebuffer = 0;
+    std::vector<const GlReplayFunction *> _functions;
+    std::vector<bool> _warned;
+
+    uint16_t _function = 0;
+    bool _callable = true;
+    uint64_t _skipped = 0;
+
+    // Room for what a call writes and for the names and strings it passes, reused call after call
+    std::deque<std::vector<uint8_t>> _outputs;
+    size_t _usedOutputs = 0;
+    std::vector<const GLchar *> _strings;
+
+    std::unordered_map<GLuint, GLuint> _names[GlNameSpaceCount];
+    std::unordered_map<uint64_t, GLsync> _syncs;
+    std::unordered_map<uint64_t, GLint> _locations;
+    std::unordered_map<uint64_t, uint8_t *> _pointers;
+    GLuint _program = 0;
+
+    GLuint _timerQueries[2] = {0, 0};
+
+    const uint8_t *read(
+        size_t size);
+
+    /// Skip the padding GlCapture puts in front of data.
+    void align();
+
+    uint8_t *output(
+        size_t size);
+
+    void writeMapped();
+};
+
+#endif // GLREPLAY_HPP
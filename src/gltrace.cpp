@@ -0,0 +1,294 @@
+#include <gltrace.hpp>
+
+#include "glloader.hpp"
+
+#include <algorithm>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+#ifdef PLAYGROUND_GL_TRACE
+#include "gltraceshims.hpp"
+
+void countGlCall(
+    uint16_t function)
+{
+    glTrace().count(function);
+}
+#endif
+
+static const char traceMagic[4] = {'P', 'G', 'G', 'T'};
+static const uint32_t traceVersion = 1;
+
+// The buffer is written out at the end of every frame, or earlier when a frame makes this many bytes
+static const size_t maxBufferedBytes = 1 << 20;
+
+template <class T>
+static void writeValue(
+    std::ofstream &file,
+    T value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void writeVarint(
+    std::vector<uint8_t> &buffer,
+    uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static const char *categoryName(
+    GlCallCategories category)
+{
+    switch (category)
+    {
+        case GlCallCategoryDraw:
+            return "draw";
+        case GlCallCategoryState:
+            return "state";
+        case GlCallCategoryUpload:
+            return "upload";
+        default:
+            return "other";
+    }
+}
+
+GlTrace::GlTrace() = default;
+
+GlTrace::~GlTrace()
+{
+    stopRecording();
+}
+
+bool GlTrace::setEnabled(
+    bool enabled)
+{
+#ifdef PLAYGROUND_GL_TRACE
+    if (enabled == _enabled)
+    {
+        return true;
+    }
+
+    if (enabled)
+    {
+        if (_counts == nullptr)
+        {
+            _counts = std::make_unique<std::atomic<uint32_t>[]>(glFunctionInfoCount);
+            _lastFrame.resize(glFunctionInfoCount, 0);
+        }
+
+        // A lazily loaded function would replace its shim on its first call
+        resolveAllOpenGl();
+        installGlShims();
+    }
+    else
+    {
+        removeGlShims();
+    }
+
+    _enabled = enabled;
+
+    return true;
+#else
+    if (enabled)
+    {
+        spdlog::warn("gl call counting needs the library built with PLAYGROUND_GL_TRACE");
+    }
+
+    return !enabled;
+#endif
+}
+
+bool GlTrace::isEnabled() const
+{
+    return _enabled;
+}
+
+bool GlTrace::startRecording(
+    const std::string &path)
+{
+#ifdef PLAYGROUND_GL_TRACE
+    stopRecording();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _file.open(path, std::ios::binary | std::ios::trunc);
+
+    if (!_file.is_open())
+    {
+        spdlog::error("failed to open {} for recording gl calls", path);
+
+        return false;
+    }
+
+    _file.write(traceMagic, sizeof(traceMagic));
+    writeValue<uint32_t>(_file, traceVersion);
+    writeValue<uint32_t>(_file, static_cast<uint32_t>(glFunctionInfoCount));
+
+    for (int i = 0; i < glFunctionInfoCount; i++)
+    {
+        auto name = std::string_view(glFunctionInfos[i].name);
+
+        writeValue<uint16_t>(_file, static_cast<uint16_t>(name.size()));
+        _file.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+
+    _buffer.clear();
+    _lastRecord = profileNow();
+    _recordedFrames = 0;
+    _recording = true;
+
+    spdlog::info("recording gl calls to {}", path);
+
+    return true;
+#else
+    spdlog::error("recording gl calls to {} needs the library built with PLAYGROUND_GL_TRACE", path);
+
+    return false;
+#endif
+}
+
+void GlTrace::stopRecording()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_file.is_open())
+    {
+        return;
+    }
+
+    _recording = false;
+
+    _file.write(reinterpret_cast<const char *>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+    _file.close();
+    _buffer.clear();
+
+    spdlog::info("recorded gl calls of {} frames", _recordedFrames);
+}
+
+bool GlTrace::isRecording() const
+{
+    return _recording;
+}
+
+void GlTrace::record(
+    uint32_t code)
+{
+    auto now = profileNow();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Stopped while this call waited for the lock
+    if (!_file.is_open())
+    {
+        return;
+    }
+
+    writeVarint(_buffer, code);
+    writeVarint(_buffer, now - std::min(now, _lastRecord));
+    _lastRecord = std::max(now, _lastRecord);
+
+    if (_buffer.size() >= maxBufferedBytes)
+    {
+        _file.write(reinterpret_cast<const char *>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+        _buffer.clear();
+    }
+}
+
+void GlTrace::endFrame()
+{
+#ifdef PLAYGROUND_GL_TRACE
+    if (!_enabled)
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("GlTrace::endFrame");
+
+    if (_recording)
+    {
+        record(0);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _file.write(reinterpret_cast<const char *>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+        _buffer.clear();
+        _recordedFrames++;
+    }
+
+    GlCallCounts counts;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (int i = 0; i < glFunctionInfoCount; i++)
+    {
+        auto count = _counts[i].exchange(0, std::memory_order_relaxed);
+
+        _lastFrame[i] = count;
+        counts.total += count;
+        counts.categories[glFunctionInfos[i].category] += count;
+    }
+
+    _lastFrameCounts = counts;
+#endif
+}
+
+GlCallCounts GlTrace::lastFrame() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _lastFrameCounts;
+}
+
+std::vector<GlFunctionCalls> GlTrace::lastFrameCalls() const
+{
+    std::vector<GlFunctionCalls> calls;
+
+#ifdef PLAYGROUND_GL_TRACE
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (size_t i = 0; i < _lastFrame.size(); i++)
+    {
+        if (_lastFrame[i] > 0)
+        {
+            calls.push_back({glFunctionInfos[i].name, glFunctionInfos[i].category, _lastFrame[i]});
+        }
+    }
+#endif
+
+    std::stable_sort(calls.begin(), calls.end(), [](const GlFunctionCalls &a, const GlFunctionCalls &b) {
+        return a.count > b.count;
+    });
+
+    return calls;
+}
+
+void GlTrace::logLastFrame(
+    size_t maxFunctions) const
+{
+    auto counts = lastFrame();
+    auto calls = lastFrameCalls();
+
+    spdlog::info("{} gl calls: {} draw, {} state, {} upload, {} other", counts.total,
+                 counts.categories[GlCallCategoryDraw], counts.categories[GlCallCategoryState],
+                 counts.categories[GlCallCategoryUpload], counts.categories[GlCallCategoryOther]);
+
+    for (size_t i = 0; i < std::min(maxFunctions, calls.size()); i++)
+    {
+        spdlog::info("  {:6} {} ({})", calls[i].count, calls[i].name, categoryName(calls[i].category));
+    }
+}
+
+GlTrace &glTrace()
+{
+    static GlTrace trace;
+
+    return trace;
+}
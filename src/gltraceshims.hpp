@@ -0,0 +1,31 @@
+#ifndef GLTRACESHIMS_HPP
+#define GLTRACESHIMS_HPP
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <gltrace.hpp>
+
+// Generated by cmake/GenerateGlTrace.cmake, one entry per glad function in the order of glad.h
+
+struct GlFunctionInfo
+{
+    const char *name;
+    GlCallCategories category;
+};
+
+extern const GlFunctionInfo glFunctionInfos[];
+
+extern const int glFunctionInfoCount;
+
+/// Point every loaded glad function at a shim that counts the call and forwards it.
+void installGlShims();
+
+/// Point the glad functions back at what they pointed at before installGlShims.
+void removeGlShims();
+
+/// Called by every shim, defined next to GlTrace.
+void countGlCall(
+    uint16_t function);
+
+#endif // GLTRACESHIMS_HPP
@@ -0,0 +1,373 @@
+#include <gpuculling.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+static const char *cullShaderSrc = GLSL450(
+    layout(local_size_x = 64) in;
+
+    struct DrawCommand {
+        uint count;
+        uint instanceCount;
+        uint firstIndex;
+        int baseVertex;
+        uint baseInstance;
+    };
+
+    layout(std430, binding = 0) readonly buffer Bounds {
+        vec4 bounds[];
+    };
+
+    layout(std430, binding = 1) readonly buffer Templates {
+        DrawCommand templates[];
+    };
+
+    layout(std430, binding = 2) writeonly buffer Commands {
+        DrawCommand commands[];
+    };
+
+    layout(std430, binding = 3) buffer Count {
+        uint visibleCount;
+    };
+
+    layout(binding = 0) uniform sampler2D u_hiZ;
+
+    uniform int u_objectCount;
+    uniform vec4 u_frustumPlanes[6];
+    uniform mat4 u_hiZViewProj;
+    uniform int u_hiZWidth;
+    uniform int u_hiZHeight;
+    uniform int u_hiZLevels;
+
+    bool isOccluded(vec4 sphere) {
+        vec3 minNdc = vec3(1.0);
+        vec3 maxNdc = vec3(-1.0);
+
+        for (int c = 0; c < 8; c++)
+        {
+            vec3 corner = sphere.xyz + sphere.w * vec3((c & 1) != 0 ? 1.0 : -1.0, (c & 2) != 0 ? 1.0 : -1.0, (c & 4) != 0 ? 1.0 : -1.0);
+            vec4 clip = u_hiZViewProj * vec4(corner, 1.0);
+
+            // Crossing the near plane, the projected box is meaningless
+            if (clip.w <= 0.0) return false;
+
+            minNdc = min(minNdc, clip.xyz / clip.w);
+            maxNdc = max(maxNdc, clip.xyz / clip.w);
+        }
+
+        vec2 minUv = clamp(minNdc.xy * 0.5 + 0.5, 0.0, 1.0);
+        vec2 maxUv = clamp(maxNdc.xy * 0.5 + 0.5, 0.0, 1.0);
+        float nearestDepth = minNdc.z * 0.5 + 0.5;
+
+        // Pick the level where the box covers at most 2x2 texels
+        vec2 sizePx = (maxUv - minUv) * vec2(u_hiZWidth, u_hiZHeight);
+        float level = clamp(ceil(log2(max(max(sizePx.x, sizePx.y), 1.0))), 0.0, float(u_hiZLevels - 1));
+
+        float farthestDepth = max(
+            max(textureLod(u_hiZ, minUv, level).r, textureLod(u_hiZ, vec2(maxUv.x, minUv.y), level).r),
+            max(textureLod(u_hiZ, vec2(minUv.x, maxUv.y), level).r, textureLod(u_hiZ, maxUv, level).r));
+
+        return nearestDepth > farthestDepth;
+    }
+
+    void main() {
+        int i = int(gl_GlobalInvocationID.x);
+
+        if (i >= u_objectCount) return;
+
+        vec4 sphere = bounds[i];
+
+        for (int p = 0; p < 6; p++)
+        {
+            if (dot(u_frustumPlanes[p].xyz, sphere.xyz) + u_frustumPlanes[p].w < -sphere.w) return;
+        }
+
+        if (u_hiZLevels > 0 && isOccluded(sphere)) return;
+
+        commands[atomicAdd(visibleCount, 1u)] = templates[i];
+    });
+
+static const char *hiZShaderSrc = GLSL450(
+    layout(local_size_x = 8, local_size_y = 8) in;
+
+    layout(binding = 0) uniform sampler2D u_source;
+    layout(r32f, binding = 0) uniform writeonly image2D u_target;
+
+    uniform int u_sourceLevel;
+    uniform int u_reduce;
+
+    float fetchSource(ivec2 p, ivec2 last) {
+        return texelFetch(u_source, min(p, last), u_sourceLevel).r;
+    }
+
+    void main() {
+        ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+        ivec2 size = imageSize(u_target);
+
+        if (p.x >= size.x || p.y >= size.y) return;
+
+        if (u_reduce == 0)
+        {
+            imageStore(u_target, p, vec4(texelFetch(u_source, p, 0).r));
+            return;
+        }
+
+        ivec2 sourceSize = textureSize(u_source, u_sourceLevel);
+        ivec2 last = sourceSize - 1;
+        ivec2 s = p * 2;
+
+        float depth = max(
+            max(fetchSource(s, last), fetchSource(s + ivec2(1, 0), last)),
+            max(fetchSource(s + ivec2(0, 1), last), fetchSource(s + ivec2(1, 1), last)));
+
+        // With odd source sizes the last column/row also covers the texels that would be dropped
+        bool oddX = (sourceSize.x & 1) != 0 && p.x == size.x - 1;
+        bool oddY = (sourceSize.y & 1) != 0 && p.y == size.y - 1;
+
+        if (oddX) depth = max(depth, max(fetchSource(s + ivec2(2, 0), last), fetchSource(s + ivec2(2, 1), last)));
+        if (oddY) depth = max(depth, max(fetchSource(s + ivec2(0, 2), last), fetchSource(s + ivec2(1, 2), last)));
+        if (oddX && oddY) depth = max(depth, fetchSource(s + ivec2(2, 2), last));
+
+        imageStore(u_target, p, vec4(depth));
+    });
+
+GpuCulling::GpuCulling() = default;
+
+GpuCulling::~GpuCulling()
+{
+    release();
+}
+
+bool GpuCulling::setup(
+    GLsizei maxObjects)
+{
+    if (!_cullShader.compile(cullShaderSrc))
+    {
+        spdlog::error("failed to compile culling shader");
+
+        return false;
+    }
+
+    if (!_hiZShader.compile(hiZShaderSrc))
+    {
+        spdlog::error("failed to compile hi-z shader");
+
+        return false;
+    }
+
+    // glMultiDrawElementsIndirectCount is core in 4.6, before that it comes from ARB_indirect_parameters
+    if (!GLAD_GL_VERSION_4_6 && !GLAD_GL_ARB_indirect_parameters)
+    {
+        spdlog::error("indirect draw counts are not supported, they need GL 4.6 or ARB_indirect_parameters");
+
+        return false;
+    }
+
+    _useIndirectParametersArb = !GLAD_GL_VERSION_4_6;
+
+    // Setting up again, e.g. after a scene change, replaces the buffers of the previous setup
+    release();
+
+    _maxObjects = maxObjects;
+
+    glCreateBuffers(1, &_boundsBuffer);
+    glNamedBufferStorage(_boundsBuffer, sizeof(glm::vec4) * maxObjects, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &_templateBuffer);
+    glNamedBufferStorage(_templateBuffer, sizeof(DrawElementsIndirectCommand) * maxObjects, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &_commandBuffer);
+    glNamedBufferStorage(_commandBuffer, sizeof(DrawElementsIndirectCommand) * maxObjects, nullptr, 0);
+
+    glCreateBuffers(1, &_countBuffer);
+    glNamedBufferStorage(_countBuffer, sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    return true;
+}
+
+bool GpuCulling::setObjects(
+    const std::vector<glm::vec4> &bounds,
+    const std::vector<DrawElementsIndirectCommand> &commands)
+{
+    if (bounds.size() != commands.size())
+    {
+        spdlog::error("bounds and commands count do not match: {} vs. {}", bounds.size(), commands.size());
+
+        return false;
+    }
+
+    if (bounds.size() > static_cast<size_t>(_maxObjects))
+    {
+        spdlog::error("too many objects to cull: {} vs. {}", bounds.size(), _maxObjects);
+
+        return false;
+    }
+
+    _objectCount = static_cast<GLsizei>(bounds.size());
+
+    glNamedBufferSubData(_boundsBuffer, 0, sizeof(glm::vec4) * bounds.size(), bounds.data());
+    glNamedBufferSubData(_templateBuffer, 0, sizeof(DrawElementsIndirectCommand) * commands.size(), commands.data());
+
+    return true;
+}
+
+void GpuCulling::buildHiZ(
+    GLuint depthTexture,
+    int width,
+    int height,
+    const glm::mat4 &viewProj)
+{
+    if (width != _hiZWidth || height != _hiZHeight)
+    {
+        if (_hiZTexture != 0)
+        {
+            glDeleteTextures(1, &_hiZTexture);
+        }
+
+        _hiZWidth = width;
+        _hiZHeight = height;
+        _hiZLevels = static_cast<int>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &_hiZTexture);
+        glTextureStorage2D(_hiZTexture, _hiZLevels, GL_R32F, width, height);
+        glTextureParameteri(_hiZTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTextureParameteri(_hiZTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(_hiZTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_hiZTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    _hiZViewProj = viewProj;
+
+    _hiZShader.setUniform("u_reduce", 0);
+    _hiZShader.setUniform("u_sourceLevel", 0);
+
+    glBindTextureUnit(0, depthTexture);
+    glBindImageTexture(0, _hiZTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    _hiZShader.dispatchInvocations(width, height);
+
+    glBindTextureUnit(0, _hiZTexture);
+    _hiZShader.setUniform("u_reduce", 1);
+
+    for (int level = 1; level < _hiZLevels; level++)
+    {
+        int levelWidth = std::max(1, width >> level);
+        int levelHeight = std::max(1, height >> level);
+
+        memoryBarrier(MemoryBarrierTextureFetch);
+
+        _hiZShader.setUniform("u_sourceLevel", level - 1);
+        glBindImageTexture(0, _hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        _hiZShader.dispatchInvocations(levelWidth, levelHeight);
+    }
+
+    memoryBarrier(MemoryBarrierTextureFetch);
+}
+
+void GpuCulling::cull(
+    const glm::mat4 &viewProj)
+{
+    // Gribb-Hartmann plane extraction, glm matrices are column major
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    }
+
+    glm::vec4 planes[6] = {
+        rows[3] + rows[0],
+        rows[3] - rows[0],
+        rows[3] + rows[1],
+        rows[3] - rows[1],
+        rows[3] + rows[2],
+        rows[3] - rows[2],
+    };
+
+    const char *planeNames[6] = {
+        "u_frustumPlanes[0]",
+        "u_frustumPlanes[1]",
+        "u_frustumPlanes[2]",
+        "u_frustumPlanes[3]",
+        "u_frustumPlanes[4]",
+        "u_frustumPlanes[5]",
+    };
+
+    for (int i = 0; i < 6; i++)
+    {
+        _cullShader.setUniform(planeNames[i], planes[i] / glm::length(glm::vec3(planes[i])));
+    }
+
+    _cullShader.setUniform("u_objectCount", _objectCount);
+    _cullShader.setUniform("u_hiZViewProj", _hiZViewProj);
+    _cullShader.setUniform("u_hiZWidth", _hiZWidth);
+    _cullShader.setUniform("u_hiZHeight", _hiZHeight);
+    _cullShader.setUniform("u_hiZLevels", _hiZLevels);
+
+    GLuint zero = 0;
+    glNamedBufferSubData(_countBuffer, 0, sizeof(GLuint), &zero);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _boundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _templateBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _countBuffer);
+    glBindTextureUnit(0, _hiZTexture);
+
+    _cullShader.dispatchInvocations(_objectCount);
+
+    memoryBarrier(MemoryBarrierCommand | MemoryBarrierShaderStorage);
+}
+
+void GpuCulling::draw(
+    GLenum mode,
+    GLenum indexType)
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, _countBuffer);
+
+    if (_useIndirectParametersArb)
+    {
+        glMultiDrawElementsIndirectCountARB(mode, indexType, nullptr, 0, _objectCount, 0);
+    }
+    else
+    {
+        glMultiDrawElementsIndirectCount(mode, indexType, nullptr, 0, _objectCount, 0);
+    }
+
+    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GpuCulling::release()
+{
+    GLuint buffers[] = {_boundsBuffer, _templateBuffer, _commandBuffer, _countBuffer};
+
+    glDeleteBuffers(4, buffers);
+
+    _boundsBuffer = 0;
+    _templateBuffer = 0;
+    _commandBuffer = 0;
+    _countBuffer = 0;
+
+    if (_hiZTexture != 0)
+    {
+        glDeleteTextures(1, &_hiZTexture);
+
+        _hiZTexture = 0;
+    }
+
+    _maxObjects = 0;
+    _objectCount = 0;
+    _hiZWidth = 0;
+    _hiZHeight = 0;
+    _hiZLevels = 0;
+}
+
+GLuint GpuCulling::commandBuffer() const
+{
+    return _commandBuffer;
+}
+
+GLuint GpuCulling::countBuffer() const
+{
+    return _countBuffer;
+}
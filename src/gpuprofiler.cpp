@@ -0,0 +1,254 @@
+#include <gpuprofiler.hpp>
+
+#include "jsonwriter.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <spdlog/spdlog.h>
+
+static const char *frameScopeName = "frame";
+
+GpuProfiler::GpuProfiler() = default;
+
+GpuProfiler::~GpuProfiler() = default;
+
+void GpuProfiler::shutdown()
+{
+    for (auto &frame : _frames)
+    {
+        if (!frame.queries.empty())
+        {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+
+        frame = Frame();
+    }
+
+    _inFrame = false;
+    _openScopes.clear();
+}
+
+void GpuProfiler::setEnabled(
+    bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool GpuProfiler::isEnabled() const
+{
+    return _enabled;
+}
+
+void GpuProfiler::beginFrame()
+{
+    _inFrame = false;
+
+    if (!_enabled)
+    {
+        return;
+    }
+
+    auto &frame = _frames[_frameIndex % FrameLatency];
+
+    if (frame.pending)
+    {
+        readBack(frame);
+    }
+
+    frame.index = _frameIndex++;
+    frame.usedQueries = 0;
+    frame.scopes.clear();
+    frame.pending = true;
+
+    _openScopes.clear();
+    _inFrame = true;
+
+    beginScope(frameScopeName);
+}
+
+void GpuProfiler::endFrame()
+{
+    if (!_inFrame)
+    {
+        return;
+    }
+
+    while (!_openScopes.empty())
+    {
+        endScope();
+    }
+
+    _inFrame = false;
+}
+
+void GpuProfiler::beginScope(
+    const char *name)
+{
+    if (!_inFrame)
+    {
+        return;
+    }
+
+    auto &frame = _frames[(_frameIndex - 1) % FrameLatency];
+
+    Scope scope = {name, static_cast<int>(_openScopes.size()), nextQuery(frame), 0};
+    glQueryCounter(scope.beginQuery, GL_TIMESTAMP);
+
+    _openScopes.push_back(frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::endScope()
+{
+    if (!_inFrame || _openScopes.empty())
+    {
+        return;
+    }
+
+    auto &frame = _frames[(_frameIndex - 1) % FrameLatency];
+    auto &scope = frame.scopes[_openScopes.back()];
+
+    scope.endQuery = nextQuery(frame);
+    glQueryCounter(scope.endQuery, GL_TIMESTAMP);
+
+    _openScopes.pop_back();
+}
+
+bool GpuProfiler::isRecording() const
+{
+    return _inFrame;
+}
+
+uint64_t GpuProfiler::currentFrameIndex() const
+{
+    return _frameIndex - 1;
+}
+
+uint64_t GpuProfiler::lastFrameIndex() const
+{
+    return _lastFrameIndex;
+}
+
+const std::vector<GpuScopeTiming> &GpuProfiler::lastFrame() const
+{
+    return _lastFrame;
+}
+
+void GpuProfiler::logLastFrame() const
+{
+    for (auto &timing : _lastFrame)
+    {
+        spdlog::info("gpu {:>{}}{} {:.3f} ms", "", timing.depth * 2, timing.name, timing.duration);
+    }
+}
+
+bool GpuProfiler::exportLastFrame(
+    const std::string &path) const
+{
+    std::ofstream file(path);
+
+    if (!file.is_open())
+    {
+        spdlog::error("failed to open {} for writing", path);
+
+        return false;
+    }
+
+    // Milliseconds down to the nanosecond, not 6 significant digits
+    file << std::fixed << std::setprecision(6);
+
+    file << "{\"frame\":" << _lastFrameIndex << ",\"scopes\":[";
+
+    for (size_t i = 0; i < _lastFrame.size(); i++)
+    {
+        auto &timing = _lastFrame[i];
+
+        file << (i == 0 ? "" : ",")
+             << "{\"name\":";
+
+        writeJsonString(file, timing.name);
+
+        file << ",\"depth\":" << timing.depth
+             << ",\"start\":" << timing.start
+             << ",\"duration\":" << timing.duration << "}";
+    }
+
+    file << "]}\n";
+
+    return true;
+}
+
+GLuint GpuProfiler::nextQuery(
+    Frame &frame)
+{
+    if (frame.usedQueries == frame.queries.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+
+        frame.queries.push_back(query);
+    }
+
+    return frame.queries[frame.usedQueries++];
+}
+
+void GpuProfiler::readBack(
+    Frame &frame)
+{
+    frame.pending = false;
+
+    if (frame.scopes.empty())
+    {
+        return;
+    }
+
+    // The frame scope ends last, once it is available all other queries of the frame are too
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame.scopes.front().endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (available == GL_FALSE)
+    {
+        spdlog::debug("dropping gpu timings of frame {}, they are not available after {} frames", frame.index, FrameLatency);
+
+        return;
+    }
+
+    GLuint64 frameStart = 0;
+    glGetQueryObjectui64v(frame.scopes.front().beginQuery, GL_QUERY_RESULT, &frameStart);
+
+    _lastFrame.clear();
+
+    for (auto &scope : frame.scopes)
+    {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(scope.beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end);
+
+        _lastFrame.push_back({
+            scope.name,
+            scope.depth,
+            (begin - frameStart) / 1.0e6,
+            (end - begin) / 1.0e6,
+        });
+    }
+
+    _lastFrameIndex = frame.index;
+}
+
+GpuProfiler &gpuProfiler()
+{
+    static GpuProfiler profiler;
+
+    return profiler;
+}
+
+GpuScope::GpuScope(
+    const char *name)
+{
+    gpuProfiler().beginScope(name);
+}
+
+GpuScope::~GpuScope()
+{
+    gpuProfiler().endScope();
+}
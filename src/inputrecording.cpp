@@ -0,0 +1,234 @@
+#include <inputrecording.hpp>
+
+#include <algorithm>
+#include <openglapp.hpp>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+
+static const char logMagic[4] = {'P', 'G', 'I', 'N'};
+static const uint32_t logVersion = 1;
+
+// type, timestamp, code, x and y of an event
+static const uint64_t eventSize = sizeof(uint8_t) + sizeof(uint64_t) + 3 * sizeof(int32_t);
+
+template <class T>
+static void writeValue(
+    std::ofstream &file,
+    T value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <class T>
+static bool readValue(
+    std::ifstream &file,
+    T &value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+InputRecording::InputRecording() = default;
+
+InputRecording::~InputRecording()
+{
+    stopRecording();
+}
+
+bool InputRecording::startRecording(
+    const std::string &path)
+{
+    stopRecording();
+    stopReplay();
+
+    _file.open(path, std::ios::binary | std::ios::trunc);
+
+    if (!_file.is_open())
+    {
+        spdlog::error("failed to open {} for recording input", path);
+
+        return false;
+    }
+
+    _file.write(logMagic, sizeof(logMagic));
+    writeValue<uint32_t>(_file, logVersion);
+
+    _recordingStart = profileNow();
+    _frameIndex = 0;
+
+    spdlog::info("recording input to {}", path);
+
+    return true;
+}
+
+void InputRecording::stopRecording()
+{
+    if (_file.is_open())
+    {
+        // A frame without events marks where the recording ended
+        writeValue<uint64_t>(_file, _frameIndex);
+        writeValue<uint32_t>(_file, 0);
+
+        _file.close();
+
+        spdlog::info("recorded input of {} frames", _frameIndex);
+    }
+}
+
+bool InputRecording::isRecording() const
+{
+    return _file.is_open();
+}
+
+bool InputRecording::startReplay(
+    const std::string &path,
+    bool quitWhenDone)
+{
+    stopRecording();
+    stopReplay();
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+        spdlog::error("failed to open input log {}", path);
+
+        return false;
+    }
+
+    auto fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    char magic[4] = {};
+    uint32_t version = 0;
+
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, logMagic) || !readValue(file, version) || version != logVersion)
+    {
+        spdlog::error("{} is not an input log of version {}", path, logVersion);
+
+        return false;
+    }
+
+    uint64_t index = 0;
+
+    while (readValue(file, index))
+    {
+        uint32_t count = 0;
+        Frame frame = {index, {}};
+
+        if (!readValue(file, count))
+        {
+            spdlog::error("input log {} is truncated", path);
+
+            return false;
+        }
+
+        // A corrupt count would otherwise allocate up to 4G events before the reads fail
+        if (count * eventSize > fileSize - static_cast<uint64_t>(file.tellg()))
+        {
+            spdlog::error("input log {} is corrupt, frame {} has more events than the file holds", path, index);
+
+            return false;
+        }
+
+        frame.events.resize(count);
+
+        for (auto &event : frame.events)
+        {
+            uint8_t type = 0;
+            int32_t code = 0, x = 0, y = 0;
+
+            if (!readValue(file, type) || !readValue(file, event.timestamp) || !readValue(file, code) || !readValue(file, x) || !readValue(file, y))
+            {
+                spdlog::error("input log {} is truncated", path);
+
+                return false;
+            }
+
+            event.type = static_cast<InputEventTypes>(type);
+            event.code = code;
+            event.x = x;
+            event.y = y;
+        }
+
+        _frames.push_back(std::move(frame));
+    }
+
+    _nextFrame = 0;
+    _frameIndex = 0;
+    _replaying = true;
+    _quitWhenDone = quitWhenDone;
+    _replayStart = profileNow();
+
+    spdlog::info("replaying {} frames with input from {}", _frames.size(), path);
+
+    return true;
+}
+
+void InputRecording::stopReplay()
+{
+    _replaying = false;
+    _frames.clear();
+    _nextFrame = 0;
+}
+
+bool InputRecording::isReplaying() const
+{
+    return _replaying;
+}
+
+void InputRecording::update(
+    OpenGLApp &app)
+{
+    if (isRecording())
+    {
+        if (!app.inputEvents.empty())
+        {
+            writeValue<uint64_t>(_file, _frameIndex);
+            writeValue<uint32_t>(_file, static_cast<uint32_t>(app.inputEvents.size()));
+
+            for (auto &event : app.inputEvents)
+            {
+                writeValue<uint8_t>(_file, static_cast<uint8_t>(event.type));
+                writeValue<uint64_t>(_file, event.timestamp - _recordingStart);
+                writeValue<int32_t>(_file, event.code);
+                writeValue<int32_t>(_file, event.x);
+                writeValue<int32_t>(_file, event.y);
+            }
+        }
+
+        _frameIndex++;
+
+        return;
+    }
+
+    if (!_replaying)
+    {
+        return;
+    }
+
+    if (_nextFrame < _frames.size() && _frames[_nextFrame].index == _frameIndex)
+    {
+        for (auto event : _frames[_nextFrame].events)
+        {
+            event.timestamp += _replayStart;
+
+            app.applyInputEvent(event);
+        }
+
+        _nextFrame++;
+    }
+
+    _frameIndex++;
+
+    if (_nextFrame >= _frames.size())
+    {
+        spdlog::info("input replay finished after {} frames", _frameIndex);
+
+        stopReplay();
+
+        if (_quitWhenDone)
+        {
+            app.quit = true;
+        }
+    }
+}
@@ -0,0 +1,175 @@
+#include <jobsystem.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <thread>
+#include <vector>
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+// Vertex normals of a height field grid, the kind of per-vertex mesh work the job system is for
+static void buildNormals(
+    const std::vector<float> &heights,
+    int size,
+    std::vector<Vec3> &normals,
+    size_t begin,
+    size_t end)
+{
+    for (auto i = begin; i < end; i++)
+    {
+        int x = static_cast<int>(i % size);
+        int y = static_cast<int>(i / size);
+
+        auto h = [&](int px, int py) {
+            px = std::clamp(px, 0, size - 1);
+            py = std::clamp(py, 0, size - 1);
+
+            return heights[py * size + px];
+        };
+
+        Vec3 n = {h(x - 1, y) - h(x + 1, y), 2.0f, h(x, y - 1) - h(x, y + 1)};
+        auto length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+        normals[i] = {n.x / length, n.y / length, n.z / length};
+    }
+}
+
+// Bounding spheres against six frustum planes, the kind of per-object work culling does
+static void cullSpheres(
+    const std::vector<float> &spheres,
+    const float planes[6][4],
+    std::vector<uint8_t> &visible,
+    size_t begin,
+    size_t end)
+{
+    for (auto i = begin; i < end; i++)
+    {
+        auto s = &spheres[i * 4];
+        bool inside = true;
+
+        for (int p = 0; p < 6 && inside; p++)
+        {
+            inside = planes[p][0] * s[0] + planes[p][1] * s[1] + planes[p][2] * s[2] + planes[p][3] > -s[3];
+        }
+
+        visible[i] = inside ? 1 : 0;
+    }
+}
+
+template <class TFunction>
+static double measure(
+    int repetitions,
+    TFunction function)
+{
+    auto best = 1.0e9;
+
+    for (int i = 0; i < repetitions; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        function();
+
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+int main(
+    int argc,
+    const char *argv[])
+{
+    const int gridSize = 2048;
+    const size_t sphereCount = 4 << 20;
+
+    std::vector<float> heights(gridSize * gridSize);
+    std::vector<Vec3> normals(heights.size());
+
+    for (size_t i = 0; i < heights.size(); i++)
+    {
+        heights[i] = std::sin(i * 0.001f) * std::cos((i / gridSize) * 0.01f) * 10.0f;
+    }
+
+    std::vector<float> spheres(sphereCount * 4);
+    std::vector<uint8_t> visible(sphereCount);
+
+    for (size_t i = 0; i < sphereCount; i++)
+    {
+        spheres[i * 4 + 0] = std::fmod(i * 0.37f, 200.0f) - 100.0f;
+        spheres[i * 4 + 1] = std::fmod(i * 0.71f, 200.0f) - 100.0f;
+        spheres[i * 4 + 2] = std::fmod(i * 0.13f, 200.0f) - 100.0f;
+        spheres[i * 4 + 3] = 1.0f;
+    }
+
+    const float planes[6][4] = {
+        {1, 0, 0, 50},
+        {-1, 0, 0, 50},
+        {0, 1, 0, 50},
+        {0, -1, 0, 50},
+        {0, 0, 1, 50},
+        {0, 0, -1, 50},
+    };
+
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+
+    if (argc > 1)
+    {
+        const char *end = argv[1] + std::strlen(argv[1]);
+        auto [parsed, error] = std::from_chars(argv[1], end, maxThreads);
+
+        if (error != std::errc() || parsed != end || maxThreads < 1)
+        {
+            spdlog::error("usage: {} [max threads]", argv[0]);
+
+            return 1;
+        }
+    }
+
+    double baseNormals = 0.0, baseCulling = 0.0;
+
+    spdlog::info("{:>8} {:>14} {:>8} {:>14} {:>8}", "threads", "normals (ms)", "speedup", "culling (ms)", "speedup");
+
+    std::vector<int> threadCounts;
+
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+
+    threadCounts.push_back(std::max(maxThreads, 1));
+
+    for (auto threads : threadCounts)
+    {
+        JobSystem jobs(threads - 1);
+
+        auto normalsTime = measure(5, [&]() {
+            jobs.parallelFor(0, heights.size(), 0, [&](size_t begin, size_t end) {
+                buildNormals(heights, gridSize, normals, begin, end);
+            });
+        });
+
+        auto cullingTime = measure(5, [&]() {
+            jobs.parallelFor(0, sphereCount, 0, [&](size_t begin, size_t end) {
+                cullSpheres(spheres, planes, visible, begin, end);
+            });
+        });
+
+        if (threads == 1)
+        {
+            baseNormals = normalsTime;
+            baseCulling = cullingTime;
+        }
+
+        spdlog::info("{:>8} {:>14.2f} {:>7.2f}x {:>14.2f} {:>7.2f}x",
+                     threads, normalsTime, baseNormals / normalsTime, cullingTime, baseCulling / cullingTime);
+    }
+
+    return 0;
+}
@@ -0,0 +1,483 @@
+#include <jobsystem.hpp>
+
+#include <algorithm>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+#include <string>
+
+struct Job
+{
+    std::function<void()> function;
+    JobCounter *counter;
+};
+
+// Chase-Lev deque with a fixed capacity, after "Correct and Efficient Work-Stealing for Weak Memory
+// Models" (Lê et al. 2013). Only the owner pushes and pops, any thread steals.
+struct JobQueue
+{
+    static constexpr int64_t Capacity = 4096;
+
+    std::atomic<int64_t> top = 0;
+    std::atomic<int64_t> bottom = 0;
+    std::atomic<Job *> jobs[Capacity];
+
+    bool push(
+        Job *job)
+    {
+        auto b = bottom.load(std::memory_order_relaxed);
+        auto t = top.load(std::memory_order_acquire);
+
+        if (b - t >= Capacity)
+        {
+            return false;
+        }
+
+        jobs[b & (Capacity - 1)].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    Job *pop()
+    {
+        auto b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+
+            return nullptr;
+        }
+
+        auto job = jobs[b & (Capacity - 1)].load(std::memory_order_relaxed);
+
+        if (t == b)
+        {
+            // The last job, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                job = nullptr;
+            }
+
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    Job *steal()
+    {
+        auto t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+        {
+            return nullptr;
+        }
+
+        auto job = jobs[t & (Capacity - 1)].load(std::memory_order_relaxed);
+
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+
+        return job;
+    }
+};
+
+struct JobThread
+{
+    const JobSystem *owner = nullptr;
+    int index = -1;
+    uint32_t random = 0x9e3779b9;
+};
+
+static thread_local JobThread jobThread;
+
+JobCounter::JobCounter() = default;
+
+JobCounter::~JobCounter()
+{
+    // The last job still holds the lock for a moment after the count dropped to zero
+    std::lock_guard<std::mutex> lock(_mutex);
+}
+
+bool JobCounter::isDone() const
+{
+    return _count.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem(
+    int workerCount)
+{
+    if (workerCount < 0)
+    {
+        workerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+    }
+
+    _mainThread = std::this_thread::get_id();
+    jobThread = {this, 0, 0x9e3779b9};
+
+    for (int i = 0; i <= workerCount; i++)
+    {
+        _queues.push_back(std::make_unique<JobQueue>());
+    }
+
+    for (int i = 1; i <= workerCount; i++)
+    {
+        _workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+
+    spdlog::debug("job system started {} workers", workerCount);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+
+        _stop = true;
+    }
+
+    _wakeUp.notify_all();
+
+    for (auto &worker : _workers)
+    {
+        worker.join();
+    }
+
+    if (jobThread.owner == this)
+    {
+        jobThread = {};
+    }
+
+    // Jobs nobody waited for are dropped
+    for (auto &queue : _queues)
+    {
+        while (auto job = queue->pop())
+        {
+            delete job;
+        }
+    }
+
+    for (auto job : _sharedJobs)
+    {
+        delete job;
+    }
+
+    for (auto job : _mainThreadJobs)
+    {
+        delete job;
+    }
+}
+
+int JobSystem::workerCount() const
+{
+    return static_cast<int>(_workers.size());
+}
+
+void JobSystem::run(
+    std::function<void()> job,
+    JobCounter *counter)
+{
+    if (counter != nullptr)
+    {
+        counter->_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    push(new Job{std::move(job), counter});
+}
+
+void JobSystem::runAfter(
+    JobCounter &dependency,
+    std::function<void()> job,
+    JobCounter *counter)
+{
+    if (counter != nullptr)
+    {
+        counter->_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto continuation = new Job{std::move(job), counter};
+
+    {
+        // finish() takes the continuations under the same lock once the count dropped to zero
+        std::lock_guard<std::mutex> lock(dependency._mutex);
+
+        if (!dependency.isDone())
+        {
+            dependency._continuations.push_back(continuation);
+
+            return;
+        }
+    }
+
+    push(continuation);
+}
+
+void JobSystem::runOnMainThread(
+    std::function<void()> job,
+    JobCounter *counter)
+{
+    if (counter != nullptr)
+    {
+        counter->_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(_mainThreadMutex);
+
+    _mainThreadJobs.push_back(new Job{std::move(job), counter});
+}
+
+void JobSystem::runMainThreadJobs()
+{
+    if (std::this_thread::get_id() != _mainThread)
+    {
+        spdlog::error("main thread jobs can only run on the thread that created the job system");
+
+        return;
+    }
+
+    std::deque<Job *> jobs;
+
+    {
+        std::lock_guard<std::mutex> lock(_mainThreadMutex);
+
+        std::swap(jobs, _mainThreadJobs);
+    }
+
+    for (auto job : jobs)
+    {
+        execute(job);
+    }
+}
+
+void JobSystem::wait(
+    JobCounter &counter)
+{
+    PROFILE_SCOPE("JobSystem::wait");
+
+    auto index = queueIndex();
+    bool mainThread = std::this_thread::get_id() == _mainThread;
+
+    while (!counter.isDone())
+    {
+        auto job = findJob(index);
+
+        if (job == nullptr && mainThread)
+        {
+            std::lock_guard<std::mutex> lock(_mainThreadMutex);
+
+            if (!_mainThreadJobs.empty())
+            {
+                job = _mainThreadJobs.front();
+                _mainThreadJobs.pop_front();
+            }
+        }
+
+        if (job != nullptr)
+        {
+            execute(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(
+    size_t begin,
+    size_t end,
+    size_t grainSize,
+    const std::function<void(size_t, size_t)> &body)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    if (grainSize == 0)
+    {
+        grainSize = std::max<size_t>((end - begin) / (_queues.size() * 4), 1);
+    }
+
+    JobCounter counter;
+
+    // The calling thread takes the last chunk itself instead of queueing it
+    auto last = begin + (end - begin - 1) / grainSize * grainSize;
+
+    for (auto chunk = begin; chunk < last; chunk += grainSize)
+    {
+        run([&body, chunk, grainSize]() { body(chunk, chunk + grainSize); }, &counter);
+    }
+
+    body(last, end);
+
+    wait(counter);
+}
+
+void JobSystem::workerLoop(
+    int index)
+{
+    jobThread = {this, index, 0x9e3779b9u * static_cast<uint32_t>(index + 1)};
+
+    auto threadName = "worker " + std::to_string(index);
+    setProfileThreadName(threadName.c_str());
+
+    while (true)
+    {
+        auto job = findJob(index);
+
+        // Spin a little before sleeping, jobs tend to come in bursts
+        for (int spin = 0; job == nullptr && spin < 64; spin++)
+        {
+            std::this_thread::yield();
+            job = findJob(index);
+        }
+
+        if (job != nullptr)
+        {
+            execute(job);
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+
+        _sleepers++;
+        _wakeUp.wait(lock, [this]() { return _stop || _queuedJobs.load() > 0; });
+        _sleepers--;
+
+        if (_stop)
+        {
+            return;
+        }
+    }
+}
+
+void JobSystem::push(
+    Job *job)
+{
+    auto index = queueIndex();
+
+    if (index < 0 || !_queues[index]->push(job))
+    {
+        std::lock_guard<std::mutex> lock(_sharedMutex);
+
+        _sharedJobs.push_back(job);
+    }
+
+    _queuedJobs.fetch_add(1);
+
+    // Either a worker about to sleep sees the job, or this sees the sleeper. Taking the lock makes sure
+    // the sleeper is waiting before it is notified.
+    if (_sleepers.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+        }
+
+        _wakeUp.notify_one();
+    }
+}
+
+Job *JobSystem::findJob(
+    int index)
+{
+    Job *job = nullptr;
+
+    if (index >= 0)
+    {
+        job = _queues[index]->pop();
+    }
+
+    if (job == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_sharedMutex);
+
+        if (!_sharedJobs.empty())
+        {
+            job = _sharedJobs.front();
+            _sharedJobs.pop_front();
+        }
+    }
+
+    if (job == nullptr)
+    {
+        auto count = static_cast<uint32_t>(_queues.size());
+
+        // xorshift, so the thieves do not all line up behind the same victim
+        auto &random = jobThread.random;
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+
+        for (uint32_t i = 0; i < count && job == nullptr; i++)
+        {
+            auto victim = (random + i) % count;
+
+            if (static_cast<int>(victim) != index)
+            {
+                job = _queues[victim]->steal();
+            }
+        }
+    }
+
+    if (job != nullptr)
+    {
+        _queuedJobs.fetch_sub(1);
+    }
+
+    return job;
+}
+
+void JobSystem::execute(
+    Job *job)
+{
+    job->function();
+
+    auto counter = job->counter;
+
+    delete job;
+
+    finish(counter);
+}
+
+void JobSystem::finish(
+    JobCounter *counter)
+{
+    if (counter == nullptr)
+    {
+        return;
+    }
+
+    std::vector<Job *> continuations;
+
+    {
+        std::lock_guard<std::mutex> lock(counter->_mutex);
+
+        if (counter->_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        std::swap(continuations, counter->_continuations);
+    }
+
+    for (auto continuation : continuations)
+    {
+        push(continuation);
+    }
+}
+
+int JobSystem::queueIndex() const
+{
+    return jobThread.owner == this ? jobThread.index : -1;
+}
@@ -0,0 +1,27 @@
+#ifndef JSONWRITER_HPP
+#define JSONWRITER_HPP
+
+#include <ostream>
+#include <string_view>
+
+/// Write str as a quoted JSON string, escaping quotes and backslashes so names can't break the file.
+inline void writeJsonString(
+    std::ostream &file,
+    std::string_view str)
+{
+    file << '"';
+
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            file << '\\';
+        }
+
+        file << c;
+    }
+
+    file << '"';
+}
+
+#endif // JSONWRITER_HPP
@@ -1,18 +1,32 @@
 #include <openglapp.hpp>
 
+#include "gldebugoutput.hpp"
+#include "glloader.hpp"
+#include "openglappcommon.hpp"
 #include <Windowsx.h>
 #include <glad/glad_wgl.h>
+#include <glcapture.hpp>
+#include <gltrace.hpp>
+#include <gpuprofiler.hpp>
+#include <memory>
+#include <profiler.hpp>
+#include <renderthread.hpp>
+#include <resourceloader.hpp>
 #include <spdlog/spdlog.h>
-
-void updateKeyStateOnKeyDown(
-    KeyButtonStates &state);
-
-void updateKeyStateOnKeyUp(
-    KeyButtonStates &state);
+#include <vector>
 
 KeyboardButtons mapKey(
     WPARAM wParam);
 
+static InputEvent inputEvent(
+    InputEventTypes type,
+    int code,
+    int x = 0,
+    int y = 0)
+{
+    return {type, profileNow(), code, x, y};
+}
+
 LRESULT WINAPI wndProc(
     HWND hWnd,
     UINT msg,
@@ -45,7 +59,7 @@ LRESULT WINAPI wndProc(
 
                 if (key != KeyUnknown)
                 {
-                    updateKeyStateOnKeyDown(app->KeyStates[key]);
+                    app->addInputEvent(inputEvent(InputEventKeyDown, key));
                 }
             }
         }
@@ -59,7 +73,7 @@ LRESULT WINAPI wndProc(
 
                 if (key != KeyUnknown)
                 {
-                    updateKeyStateOnKeyUp(app->KeyStates[key]);
+                    app->addInputEvent(inputEvent(InputEventKeyUp, key));
                 }
             }
         }
@@ -69,7 +83,7 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                updateKeyStateOnKeyDown(app->ButtonStates[MouseLeftButton]);
+                app->addInputEvent(inputEvent(InputEventButtonDown, MouseLeftButton));
             }
         }
         break;
@@ -78,7 +92,7 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                updateKeyStateOnKeyUp(app->ButtonStates[MouseLeftButton]);
+                app->addInputEvent(inputEvent(InputEventButtonUp, MouseLeftButton));
             }
         }
         break;
@@ -87,7 +101,7 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                updateKeyStateOnKeyDown(app->ButtonStates[MouseRightButton]);
+                app->addInputEvent(inputEvent(InputEventButtonDown, MouseRightButton));
             }
         }
         break;
@@ -96,7 +110,7 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                updateKeyStateOnKeyUp(app->ButtonStates[MouseRightButton]);
+                app->addInputEvent(inputEvent(InputEventButtonUp, MouseRightButton));
             }
         }
         break;
@@ -105,7 +119,7 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                updateKeyStateOnKeyDown(app->ButtonStates[MouseMiddleButton]);
+                app->addInputEvent(inputEvent(InputEventButtonDown, MouseMiddleButton));
             }
         }
         break;
@@ -114,25 +128,43 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                updateKeyStateOnKeyUp(app->ButtonStates[MouseMiddleButton]);
+                app->addInputEvent(inputEvent(InputEventButtonUp, MouseMiddleButton));
             }
         }
         break;
 
         case WM_MOUSEMOVE:
         {
-            static LPARAM prevParam = lParam;
-
             if (app != nullptr)
             {
-                app->mousePosX = GET_X_LPARAM(lParam);
-                app->mousePosY = GET_Y_LPARAM(lParam);
+                app->addInputEvent(inputEvent(InputEventMouseMove, 0, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)));
+            }
+        }
+        break;
+
+        case WM_INPUT:
+        {
+            RAWINPUT input;
+            UINT size = sizeof(input);
 
-                app->mouseDiffX = GET_X_LPARAM(prevParam) - app->mousePosX;
-                app->mouseDiffY = GET_Y_LPARAM(prevParam) - app->mousePosY;
+            if (app != nullptr && GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &input, &size, sizeof(RAWINPUTHEADER)) != UINT(-1))
+            {
+                // Absolute devices, like tablets and remote desktop sessions, are left to WM_MOUSEMOVE
+                if (input.header.dwType == RIM_TYPEMOUSE && (input.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) == 0)
+                {
+                    app->addInputEvent(inputEvent(InputEventMouseRawMotion, 0, input.data.mouse.lLastX, input.data.mouse.lLastY));
+                }
             }
+        }
+        break;
 
-            prevParam = lParam;
+        case WM_PAINT:
+        {
+            // The window was exposed, DefWindowProc validates it and the next frame repaints it
+            if (app != nullptr)
+            {
+                app->requestRedraw();
+            }
         }
         break;
 
@@ -140,10 +172,7 @@ LRESULT WINAPI wndProc(
         {
             if (app != nullptr)
             {
-                app->width = LOWORD(lParam);
-                app->height = HIWORD(lParam);
-
-                app->isResizedInCurrentFrame = true;
+                app->addInputEvent(inputEvent(InputEventResize, 0, LOWORD(lParam), HIWORD(lParam)));
             }
         }
         break;
@@ -159,59 +188,299 @@ LRESULT WINAPI wndProc(
     return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
-void OpenGLMessageCallback(
-    unsigned source,
-    unsigned type,
-    unsigned id,
-    unsigned severity,
-    int length,
-    const char *message,
-    const void *userParam)
+// Dispatch all queued messages, returns false when the app was asked to quit
+static bool pumpMessages()
 {
-    (void)source;
-    (void)type;
-    (void)id;
-    (void)length;
-    (void)userParam;
-
-    switch (severity)
-    {
-        case GL_DEBUG_SEVERITY_HIGH:
-            spdlog::critical("{} - {}", source, message);
-            return;
-        case GL_DEBUG_SEVERITY_MEDIUM:
-            spdlog::error("{} - {}", source, message);
-            return;
-        case GL_DEBUG_SEVERITY_LOW:
-            spdlog::warn("{} - {}", source, message);
-            return;
-        case GL_DEBUG_SEVERITY_NOTIFICATION:
-            spdlog::trace("{} - {}", source, message);
-            return;
-    }
-
-    spdlog::debug("Unknown severity level!");
-    spdlog::debug(message);
+    PROFILE_SCOPE("message pump");
+
+    MSG msg = {};
+
+    while (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
+    {
+        if (msg.message == WM_QUIT)
+        {
+            spdlog::info("exiting app with return code {}", msg.wParam);
+
+            return false;
+        }
+
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    return true;
+}
+
+void applySwapInterval(
+    SwapIntervals interval)
+{
+    if (!GLAD_WGL_EXT_swap_control)
+    {
+        spdlog::warn("WGL_EXT_swap_control is not supported, the swap interval stays at the driver default");
+
+        return;
+    }
+
+    if (interval == SwapIntervalAdaptive && !GLAD_WGL_EXT_swap_control_tear)
+    {
+        spdlog::warn("WGL_EXT_swap_control_tear is not supported, using vsync instead of adaptive vsync");
+
+        interval = SwapIntervalVSync;
+    }
+
+    if (wglSwapIntervalEXT(interval) == FALSE)
+    {
+        spdlog::error("failed to set swap interval {}", static_cast<int>(interval));
+    }
+}
+
+// wglGetProcAddress only knows functions newer than GL 1.1, those are exported by opengl32.dll
+static void *getGlProcAddress(
+    const char *name)
+{
+    auto function = reinterpret_cast<void *>(wglGetProcAddress(name));
+    auto value = reinterpret_cast<intptr_t>(function);
+
+    if (value == 0 || value == 1 || value == 2 || value == 3 || value == -1)
+    {
+        static HMODULE openGl = GetModuleHandle("opengl32.dll");
+
+        function = reinterpret_cast<void *>(GetProcAddress(openGl, name));
+    }
+
+    return function;
+}
+
+static bool loadWglExtensions(
+    HINSTANCE hInstance)
+{
+    const char *windowClassName = "DummyOpenGLAppWindow";
+
+    WNDCLASSEX wc = {
+        .cbSize = sizeof(WNDCLASSEX),
+        .style = CS_OWNDC,
+        .lpfnWndProc = DefWindowProc,
+        .hInstance = hInstance,
+        .lpszClassName = windowClassName,
+    };
+    RegisterClassEx(&wc);
+
+    HWND hwnd = CreateWindow(
+        windowClassName,
+        "",
+        WS_OVERLAPPEDWINDOW,
+        0, 0,
+        1, 1,
+        NULL, NULL,
+        hInstance,
+        NULL);
+
+    HDC hdc = hwnd != NULL ? GetDC(hwnd) : NULL;
+
+    PIXELFORMATDESCRIPTOR pfd = {
+        .nSize = sizeof(PIXELFORMATDESCRIPTOR),
+        .nVersion = 1,
+        .dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
+        .iPixelType = PFD_TYPE_RGBA,
+        .cColorBits = 32,
+        .cDepthBits = 24,
+        .iLayerType = PFD_MAIN_PLANE,
+    };
+
+    HGLRC hrc = NULL;
+    bool loaded = false;
+
+    if (hdc != NULL && SetPixelFormat(hdc, ChoosePixelFormat(hdc, &pfd), &pfd) != FALSE)
+    {
+        hrc = wglCreateContext(hdc);
+
+        if (hrc != NULL && wglMakeCurrent(hdc, hrc) != FALSE)
+        {
+            loaded = gladLoadWGL(hdc) != 0 && GLAD_WGL_ARB_create_context;
+        }
+    }
+
+    wglMakeCurrent(NULL, NULL);
+
+    if (hrc != NULL)
+    {
+        wglDeleteContext(hrc);
+    }
+
+    if (hdc != NULL)
+    {
+        ReleaseDC(hwnd, hdc);
+    }
+
+    if (hwnd != NULL)
+    {
+        DestroyWindow(hwnd);
+    }
+
+    UnregisterClass(windowClassName, hInstance);
+
+    if (!loaded)
+    {
+        spdlog::error("failed to load wgl extensions, WGL_ARB_create_context is required");
+    }
+
+    return loaded;
 }
 
-void enableOpenGlDebug()
+static int depthBits(
+    DepthStencilFormats format)
 {
-    glEnable(GL_DEBUG_OUTPUT);
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glDebugMessageCallback(OpenGLMessageCallback, nullptr);
-
-    glDebugMessageControl(
-        GL_DONT_CARE,
-        GL_DONT_CARE,
-        GL_DEBUG_SEVERITY_NOTIFICATION,
-        0,
-        NULL,
-        GL_TRUE);
+    switch (format)
+    {
+        case DepthStencilFormatNone:
+            return 0;
+        case DepthStencilFormatDepth16:
+            return 16;
+        default:
+            return 24;
+    }
+}
+
+static int choosePixelFormat(
+    HDC hdc,
+    const ContextOptions &options)
+{
+    auto stencilBits = options.depthStencil == DepthStencilFormatDepth24Stencil8 ? 8 : 0;
+
+    if (!GLAD_WGL_ARB_pixel_format)
+    {
+        spdlog::warn("WGL_ARB_pixel_format is not supported, the framebuffer has no multisampling and no sRGB");
+
+        PIXELFORMATDESCRIPTOR pfd = {
+            .nSize = sizeof(PIXELFORMATDESCRIPTOR),
+            .nVersion = 1,
+            .dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
+            .iPixelType = PFD_TYPE_RGBA,
+            .cColorBits = 32,
+            .cDepthBits = static_cast<BYTE>(depthBits(options.depthStencil)),
+            .cStencilBits = static_cast<BYTE>(stencilBits),
+            .iLayerType = PFD_MAIN_PLANE,
+        };
+
+        auto pixelFormat = ChoosePixelFormat(hdc, &pfd);
+
+        // Like with WGL_ARB_pixel_format the depth and stencil bits are only minimums
+        PIXELFORMATDESCRIPTOR chosen = {};
+
+        if (pixelFormat != 0 && DescribePixelFormat(hdc, pixelFormat, sizeof(chosen), &chosen) != 0 && (chosen.cDepthBits != pfd.cDepthBits || chosen.cStencilBits != pfd.cStencilBits))
+        {
+            spdlog::warn("got a pixel format with {} depth and {} stencil bits instead of {} and {}", chosen.cDepthBits, chosen.cStencilBits, pfd.cDepthBits, pfd.cStencilBits);
+        }
+
+        return pixelFormat;
+    }
+
+    std::vector<int> attribs = {
+        WGL_DRAW_TO_WINDOW_ARB, GL_TRUE,
+        WGL_SUPPORT_OPENGL_ARB, GL_TRUE,
+        WGL_DOUBLE_BUFFER_ARB, GL_TRUE,
+        WGL_ACCELERATION_ARB, WGL_FULL_ACCELERATION_ARB,
+        WGL_PIXEL_TYPE_ARB, WGL_TYPE_RGBA_ARB,
+        WGL_COLOR_BITS_ARB, 24,
+        WGL_ALPHA_BITS_ARB, 8,
+        WGL_DEPTH_BITS_ARB, depthBits(options.depthStencil),
+        WGL_STENCIL_BITS_ARB, stencilBits,
+    };
+
+    if (options.samples > 0)
+    {
+        if (GLAD_WGL_ARB_multisample)
+        {
+            attribs.insert(attribs.end(), {WGL_SAMPLE_BUFFERS_ARB, 1, WGL_SAMPLES_ARB, options.samples});
+        }
+        else
+        {
+            spdlog::warn("WGL_ARB_multisample is not supported, the framebuffer is not multisampled");
+        }
+    }
+
+    if (options.srgb)
+    {
+        if (GLAD_WGL_ARB_framebuffer_sRGB || GLAD_WGL_EXT_framebuffer_sRGB)
+        {
+            attribs.insert(attribs.end(), {WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB, GL_TRUE});
+        }
+        else
+        {
+            spdlog::warn("WGL_ARB_framebuffer_sRGB is not supported, the framebuffer is not sRGB capable");
+        }
+    }
+
+    attribs.push_back(0);
+
+    // Depth and stencil bits are minimums, a request for no depth buffer still matches D24S8 formats
+    int pixelFormats[64] = {};
+    UINT count = 0;
+
+    if (wglChoosePixelFormatARB(hdc, attribs.data(), nullptr, 64, pixelFormats, &count) == FALSE || count == 0)
+    {
+        return 0;
+    }
+
+    // The formats come sorted best match first, take the first one with exactly the bits asked for
+    const int queried[] = {WGL_DEPTH_BITS_ARB, WGL_STENCIL_BITS_ARB};
+
+    for (UINT i = 0; i < count; i++)
+    {
+        int values[2] = {};
+
+        if (wglGetPixelFormatAttribivARB(hdc, pixelFormats[i], 0, 2, queried, values) == FALSE)
+        {
+            continue;
+        }
+
+        if (values[0] == depthBits(options.depthStencil) && values[1] == stencilBits)
+        {
+            return pixelFormats[i];
+        }
+    }
+
+    spdlog::warn("no pixel format with exactly {} depth and {} stencil bits, using one with more", depthBits(options.depthStencil), stencilBits);
+
+    return pixelFormats[0];
+}
+
+static std::vector<int> contextAttribs(
+    const ContextOptions &options)
+{
+    std::vector<int> attribs = {
+        WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
+        WGL_CONTEXT_MINOR_VERSION_ARB, 6,
+        WGL_CONTEXT_FLAGS_ARB, 0,
+    };
+
+    if (GLAD_WGL_ARB_create_context_profile)
+    {
+        attribs.insert(attribs.end(), {WGL_CONTEXT_PROFILE_MASK_ARB, options.coreProfile ? WGL_CONTEXT_CORE_PROFILE_BIT_ARB : WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB});
+    }
+
+    if (options.noError)
+    {
+        if (GLAD_WGL_ARB_create_context_no_error)
+        {
+            attribs.insert(attribs.end(), {WGL_CONTEXT_OPENGL_NO_ERROR_ARB, GL_TRUE});
+        }
+        else
+        {
+            spdlog::warn("WGL_ARB_create_context_no_error is not supported, errors are still checked");
+        }
+    }
+
+    attribs.push_back(0);
+
+    return attribs;
 }
 
 bool openApp(
     OpenGLApp &app)
 {
+    PROFILE_SCOPE("openApp");
+
     const char *windowClassName = "FullOpenGLAppWindow";
 
     HINSTANCE hInstance = GetModuleHandle(NULL);
@@ -258,6 +527,10 @@ bool embedApp(
     long window,
     OpenGLApp &app)
 {
+    PROFILE_SCOPE("embedApp");
+
+    setProfileThreadName("main");
+
     const char *windowClassName = "ChildOpenGLAppWindow";
 
     HWND hwnd = (HWND)window;
@@ -274,36 +547,25 @@ bool embedApp(
         return false;
     }
 
-    static PIXELFORMATDESCRIPTOR pfd =
-        {
-            sizeof(PIXELFORMATDESCRIPTOR), // Size Of This Pixel Format Descriptor
-            1,                             // Version Number
-            PFD_DRAW_TO_WINDOW |           // Format Must Support Window
-                PFD_SUPPORT_OPENGL |       // Format Must Support CodeGL
-                PFD_DOUBLEBUFFER,          // Must Support Double Buffering
-            PFD_TYPE_RGBA,                 // Request An RGBA Format
-            32,                            // Select Our Color Depth
-            0, 0, 0, 0, 0, 0,              // Color Bits Ignored
-            0,                             // No Alpha Buffer
-            0,                             // Shift Bit Ignored
-            0,                             // No Accumulation Buffer
-            0, 0, 0, 0,                    // Accumulation Bits Ignored
-            24,                            // 24Bit Z-Buffer (Depth Buffer)
-            0,                             // No Stencil Buffer
-            0,                             // No Auxiliary Buffer
-            PFD_MAIN_PLANE,                // Main Drawing Layer
-            0,                             // Reserved
-            0, 0, 0                        // Layer Masks Ignored
-        };
+    // wglChoosePixelFormatARB needs a current context, and the pixel format of a window can only be set
+    // once, so the extensions are loaded through a context on a dummy window first
+    if (!loadWglExtensions(hInstance))
+    {
+        return false;
+    }
+
+    auto pixelFormat = choosePixelFormat(hdc, app.contextOptions);
 
-    auto pixelFormat = ChoosePixelFormat(hdc, &pfd);
-    if (pixelFormat == false)
+    if (pixelFormat == 0)
     {
         spdlog::error("failed to choose pixel format");
 
         return false;
     }
 
+    PIXELFORMATDESCRIPTOR pfd = {};
+    DescribePixelFormat(hdc, pixelFormat, sizeof(pfd), &pfd);
+
     if (SetPixelFormat(hdc, pixelFormat, &pfd) == FALSE)
     {
         spdlog::error("failed to set pixel format");
@@ -311,99 +573,169 @@ bool embedApp(
         return false;
     }
 
-    auto tempRc = wglCreateContext(hdc);
-
-    if (tempRc == 0)
-    {
-        spdlog::error("failed to create render context");
+    auto attribList = contextAttribs(app.contextOptions);
 
-        return false;
-    }
+    hrc = wglCreateContextAttribsARB(hdc, NULL, attribList.data());
 
-    if (!wglMakeCurrent(hdc, tempRc))
+    if (hrc == 0)
     {
-        spdlog::error("failed to set current render context");
+        spdlog::error("failed to create opengl 4.6 render context");
 
         return false;
     }
 
-    gladLoadWGL(hdc);
+    // Shares all sharable objects with hrc, a loader thread makes it current to upload in the background
+    HGLRC loaderRc = NULL;
 
-    GLint attribList[] =
+    if (app.backgroundLoading)
+    {
+        loaderRc = wglCreateContextAttribsARB(hdc, hrc, attribList.data());
+
+        if (loaderRc == 0)
         {
-            WGL_CONTEXT_MAJOR_VERSION_ARB,
-            4,
-            WGL_CONTEXT_MINOR_VERSION_ARB,
-            6,
-            WGL_CONTEXT_FLAGS_ARB,
-            0,
-            0,
-        };
-    hrc = wglCreateContextAttribsARB(hdc, NULL, attribList);
+            spdlog::error("failed to create shared loader context, uploads stay on the main context");
+        }
+    }
 
-    if (hrc == 0)
+    if (!wglMakeCurrent(hdc, hrc))
     {
-        spdlog::error("failed to create opengl 4.6 render context");
+        spdlog::error("failed to set current render context");
+
+        wglDeleteContext(hrc);
 
         return false;
     }
 
-    wglDeleteContext(tempRc);
-
-    if (!wglMakeCurrent(hdc, hrc))
+    if (!loadOpenGl(getGlProcAddress))
     {
-        spdlog::error("failed to set current render context");
+        spdlog::error("failed to load opengl functions");
 
+        wglMakeCurrent(NULL, NULL);
         wglDeleteContext(hrc);
 
         return false;
     }
 
-    gladLoadGL();
-    enableOpenGlDebug();
+    enableOpenGlDebug(app.debugOutput);
+
+    if (app.countGlCalls)
+    {
+        glTrace().setEnabled(true);
+    }
+
+    if (!app.glCapturePath.empty())
+    {
+        glCapture().start(app.glCapturePath, app.glCaptureFrames, app.width, app.height, app.framebuffer);
+    }
 
     ShowWindow(hwnd, SW_SHOWDEFAULT);
     UpdateWindow(hwnd);
 
+    if (app.rawMouseInput)
+    {
+        // Generic desktop page, mouse usage. Motion arrives as WM_INPUT at the rate the mouse reports it
+        RAWINPUTDEVICE mouse = {0x01, 0x02, 0, hwnd};
+
+        if (RegisterRawInputDevices(&mouse, 1, sizeof(mouse)) == FALSE)
+        {
+            spdlog::warn("failed to register raw mouse input, mouse motion falls back to cursor positions");
+        }
+    }
+
     glViewport(0, 0, app.width, app.height);
 
     spdlog::info("window with opengl 4.6 context created");
 
-    app.GameLoop = [hwnd, hdc]() -> bool {
-        MSG msg = {};
+    applySwapInterval(app.swapInterval);
 
-        SwapBuffers(hdc);
+    app.MakeCurrent = [hdc, hrc](bool current) -> bool {
+        return wglMakeCurrent(current ? hdc : NULL, current ? hrc : NULL) != FALSE;
+    };
 
-        auto app = reinterpret_cast<OpenGLApp *>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    if (loaderRc != NULL)
+    {
+        app.MakeLoaderCurrent = [hdc, loaderRc](bool current) -> bool {
+            return wglMakeCurrent(current ? hdc : NULL, current ? loaderRc : NULL) != FALSE;
+        };
+    }
+
+    // The app outlives its Present, which runs on the render thread when there is one
+    app.Present = [app = &app, hdc, swapInterval = app.swapInterval.load(), fences = std::deque<GLsync>()]() mutable {
+        gpuProfiler().endFrame();
 
-        if (app != nullptr)
         {
-            for (int i = 0; i < KeyboardButtonsCount; i++)
-            {
-                if (app->KeyStates[i] == KeyButtonStates::KeyButtonStatePressed) app->KeyStates[i] = KeyButtonStates::KeyButtonStateDown;
-                if (app->KeyStates[i] == KeyButtonStates::KeyButtonStateReleased) app->KeyStates[i] = KeyButtonStates::KeyButtonStateUp;
-            }
+            PROFILE_SCOPE("SwapBuffers");
 
-            app->isResizedInCurrentFrame = false;
+            SwapBuffers(hdc);
         }
 
-        while (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
+        if (auto interval = app->swapInterval.load(); interval != swapInterval)
         {
-            if (msg.message == WM_QUIT)
-            {
-                spdlog::info("exiting app with return code {}", msg.wParam);
+            swapInterval = interval;
+            applySwapInterval(swapInterval);
+        }
 
-                return false;
-            }
+        finishPresent(*app, fences);
+    };
+
+    app.Wake = [hwnd]() {
+        PostMessage(hwnd, WM_NULL, 0, 0);
+    };
+
+    // GWLP_USERDATA is only set on windows openApp created, embedded windows belong to the host
+    app.GameLoop = [app = &app, frameLimiter = std::make_shared<FrameLimiter>()]() -> bool {
+        if (app->quit)
+        {
+            return false;
+        }
+
+        endAppFrame(*app, *frameLimiter);
+
+        if (!pumpMessages())
+        {
+            return false;
+        }
+
+        auto waitForMessages = [](int timeout) -> bool {
+            MsgWaitForMultipleObjects(0, NULL, FALSE, timeout < 0 ? INFINITE : static_cast<DWORD>(timeout), QS_ALLINPUT);
+
+            return pumpMessages();
+        };
 
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
+        if (!waitForRedraw(*app, waitForMessages))
+        {
+            return false;
         }
 
+        beginAppFrame(*app);
+
         return true;
     };
 
-    app.Cleanup = [hwnd, windowClassName, hInstance]() -> int {
+    app.Cleanup = [app = &app, hwnd, windowClassName, hInstance, loaderRc]() -> int {
+        if (app->renderThread != nullptr)
+        {
+            app->renderThread->stop();
+        }
+
+        if (app->resourceLoader != nullptr)
+        {
+            app->resourceLoader->stop();
+        }
+
+        glCapture().stop();
+        glTrace().stopRecording();
+        glTrace().setEnabled(false);
+        gpuProfiler().shutdown();
+        shutdownOpenGlDebug();
+
+        logOpenGlLoaderStats();
+
+        if (loaderRc != NULL)
+        {
+            wglDeleteContext(loaderRc);
+        }
+
         ShowCursor(true);
         DestroyWindow(hwnd);
         UnregisterClass(windowClassName, hInstance);
@@ -414,32 +746,6 @@ bool embedApp(
     return true;
 }
 
-void updateKeyStateOnKeyDown(
-    KeyButtonStates &state)
-{
-    if (state == KeyButtonStateUp)
-    {
-        state = KeyButtonStatePressed;
-    }
-    else if (state == KeyButtonStateDown || state == KeyButtonStatePressed)
-    {
-        state = KeyButtonStateDown;
-    }
-}
-
-void updateKeyStateOnKeyUp(
-    KeyButtonStates &state)
-{
-    if (state == KeyButtonStateDown)
-    {
-        state = KeyButtonStateReleased;
-    }
-    else if (state == KeyButtonStateUp || state == KeyButtonStateReleased)
-    {
-        state = KeyButtonStateUp;
-    }
-}
-
 MouseButtons mapButton(
     WPARAM wParam)
 {
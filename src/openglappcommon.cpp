@@ -0,0 +1,433 @@
+#include "openglappcommon.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glcapture.hpp>
+#include <gltrace.hpp>
+#include <gpuprofiler.hpp>
+#include <profiler.hpp>
+#include <renderthread.hpp>
+#include <resourceloader.hpp>
+#include <spdlog/spdlog.h>
+
+void limitFramesInFlight(
+    std::deque<GLsync> &fences,
+    int maxFramesInFlight)
+{
+    PROFILE_SCOPE("limitFramesInFlight");
+
+    if (maxFramesInFlight <= 0)
+    {
+        for (auto fence : fences)
+        {
+            glDeleteSync(fence);
+        }
+
+        fences.clear();
+
+        return;
+    }
+
+    fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    while (static_cast<int>(fences.size()) > maxFramesInFlight)
+    {
+        // Flushing makes sure the fence reaches the GPU, a second is only hit when the GPU hangs
+        if (glClientWaitSync(fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_WAIT_FAILED)
+        {
+            spdlog::error("failed to wait for frame fence");
+        }
+
+        glDeleteSync(fences.front());
+        fences.pop_front();
+    }
+}
+
+void finishPresent(
+    OpenGLApp &app,
+    std::deque<GLsync> &fences)
+{
+    limitFramesInFlight(fences, app.maxFramesInFlight);
+
+    glTrace().endFrame();
+    glCapture().endFrame();
+
+    gpuProfiler().beginFrame();
+
+    if (app.resourceLoader != nullptr)
+    {
+        app.resourceLoader->update();
+    }
+}
+
+void endAppFrame(
+    OpenGLApp &app,
+    FrameLimiter &frameLimiter)
+{
+    app.frameStats.beginPresent();
+
+    if (app.renderThread != nullptr)
+    {
+        app.renderThread->endFrame();
+    }
+    else
+    {
+        app.Present();
+    }
+
+    app.frameStats.endPresent();
+
+    if (app.maxFrameRate != frameLimiter.frameRate())
+    {
+        frameLimiter.setFrameRate(app.maxFrameRate);
+    }
+
+    // Pace before the input is read, so the frame starts with the freshest input there is
+    {
+        PROFILE_SCOPE("frame limiter");
+
+        frameLimiter.wait();
+    }
+
+    app.ageInput();
+}
+
+// While uploads are pending, frames keep coming at this interval so their ready callbacks run
+static constexpr double LoadPollInterval = 1.0 / 30.0;
+
+static bool hasPendingInput(
+    const OpenGLApp &app)
+{
+    return !app.inputEvents.empty() || app.isResizedInCurrentFrame || app.mouseDiffX != 0 || app.mouseDiffY != 0 ||
+           !app._changedKeys.empty() || !app._changedButtons.empty();
+}
+
+// Seconds until the next frame is due without any input, negative when nothing is due
+static double timeUntilRedraw(
+    const OpenGLApp &app,
+    FrameStats::Clock::time_point now)
+{
+    auto interval = app.redrawInterval;
+
+    if (app.resourceLoader != nullptr && app.resourceLoader->pendingCount() > 0 && (interval <= 0.0 || interval > LoadPollInterval))
+    {
+        interval = LoadPollInterval;
+    }
+
+    if (interval <= 0.0)
+    {
+        return -1.0;
+    }
+
+    return std::max(interval - std::chrono::duration<double>(now - app._lastRedraw).count(), 0.0);
+}
+
+bool waitForRedraw(
+    OpenGLApp &app,
+    const std::function<bool(int)> &wait)
+{
+    if (!app.onDemandRendering || app.inputRecording.isReplaying())
+    {
+        app._redrawRequested = false;
+        app._lastRedraw = FrameStats::Clock::now();
+
+        return !app.quit;
+    }
+
+    PROFILE_SCOPE("wait for redraw");
+
+    auto idleStart = FrameStats::Clock::now();
+
+    while (!app.quit && !app._redrawRequested.exchange(false) && !hasPendingInput(app))
+    {
+        auto remaining = timeUntilRedraw(app, FrameStats::Clock::now());
+
+        if (remaining == 0.0)
+        {
+            break;
+        }
+
+        // Round up, waking a little early would just wait again for the remaining fraction
+        if (!wait(remaining < 0.0 ? -1 : static_cast<int>(std::ceil(remaining * 1000.0))))
+        {
+            return false;
+        }
+    }
+
+    app._lastRedraw = FrameStats::Clock::now();
+    app.frameStats.skipIdle(app._lastRedraw - idleStart);
+
+    return !app.quit;
+}
+
+void beginAppFrame(
+    OpenGLApp &app)
+{
+    app.inputRecording.update(app);
+
+    app.frameStats.beginFrame();
+
+    if (app.countGlCalls)
+    {
+        app.glCalls = glTrace().lastFrame();
+    }
+
+    // The GPU profiler belongs to the render thread when there is one
+    app.flightRecorder.recordFrame(app.frameStats, app.renderThread == nullptr);
+}
+
+static void pressState(
+    KeyButtonStates &state,
+    int code,
+    std::vector<int> &changed,
+    std::vector<int> &pendingReleases)
+{
+    if (state == KeyButtonStateUp || state == KeyButtonStateReleased)
+    {
+        state = KeyButtonStatePressed;
+        changed.push_back(code);
+    }
+    else if (state == KeyButtonStatePressed)
+    {
+        // Pressed, released and pressed again within one frame, it stays down after all
+        std::erase(pendingReleases, code);
+    }
+}
+
+static void releaseState(
+    KeyButtonStates &state,
+    int code,
+    std::vector<int> &changed,
+    std::vector<int> &pendingReleases)
+{
+    if (state == KeyButtonStateDown)
+    {
+        state = KeyButtonStateReleased;
+        changed.push_back(code);
+    }
+    else if (state == KeyButtonStatePressed && std::find(pendingReleases.begin(), pendingReleases.end(), code) == pendingReleases.end())
+    {
+        // Released in the frame it was pressed in, the press stays visible for this frame and the release for the next
+        pendingReleases.push_back(code);
+    }
+}
+
+static void ageStates(
+    KeyButtonStates *states,
+    std::vector<int> &changed,
+    std::vector<int> &pendingReleases)
+{
+    for (auto code : changed)
+    {
+        if (states[code] == KeyButtonStatePressed) states[code] = KeyButtonStateDown;
+        if (states[code] == KeyButtonStateReleased) states[code] = KeyButtonStateUp;
+    }
+
+    changed.clear();
+
+    for (auto code : pendingReleases)
+    {
+        states[code] = KeyButtonStateReleased;
+        changed.push_back(code);
+    }
+
+    pendingReleases.clear();
+}
+
+void OpenGLApp::addInputEvent(
+    const InputEvent &event)
+{
+    if (inputRecording.isReplaying())
+    {
+        return;
+    }
+
+    applyInputEvent(event);
+}
+
+void OpenGLApp::applyInputEvent(
+    const InputEvent &event)
+{
+    // A recording needs every raw sample to reproduce the per-frame sums
+    if (event.type != InputEventMouseRawMotion || rawMouseSamples || inputRecording.isRecording())
+    {
+        inputEvents.push_back(event);
+    }
+
+    switch (event.type)
+    {
+        case InputEventKeyDown:
+        {
+            if (event.code > KeyUnknown && event.code < KeyboardButtonsCount)
+            {
+                pressState(KeyStates[event.code], event.code, _changedKeys, _pendingKeyReleases);
+            }
+        }
+        break;
+
+        case InputEventKeyUp:
+        {
+            if (event.code > KeyUnknown && event.code < KeyboardButtonsCount)
+            {
+                releaseState(KeyStates[event.code], event.code, _changedKeys, _pendingKeyReleases);
+            }
+        }
+        break;
+
+        case InputEventButtonDown:
+        {
+            if (event.code > MouseUnknown && event.code < MouseButtonsCount)
+            {
+                pressState(ButtonStates[event.code], event.code, _changedButtons, _pendingButtonReleases);
+            }
+        }
+        break;
+
+        case InputEventButtonUp:
+        {
+            if (event.code > MouseUnknown && event.code < MouseButtonsCount)
+            {
+                releaseState(ButtonStates[event.code], event.code, _changedButtons, _pendingButtonReleases);
+            }
+        }
+        break;
+
+        case InputEventMouseMove:
+        {
+            if (_hasMousePosition)
+            {
+                _cursorDiffX += mousePosX - event.x;
+                _cursorDiffY += mousePosY - event.y;
+
+                if (!_rawMouseActive)
+                {
+                    mouseDiffX += mousePosX - event.x;
+                    mouseDiffY += mousePosY - event.y;
+                }
+            }
+
+            mousePosX = event.x;
+            mousePosY = event.y;
+
+            _hasMousePosition = true;
+        }
+        break;
+
+        case InputEventMouseRawMotion:
+        {
+            // Relative raw motion replaces the cursor differences for the rest of the frame, including
+            // the ones that already came in. Frames without it, like with an absolute device, keep them
+            if (!_rawMouseActive)
+            {
+                mouseDiffX -= _cursorDiffX;
+                mouseDiffY -= _cursorDiffY;
+
+                _rawMouseActive = true;
+            }
+
+            mouseDiffX -= event.x;
+            mouseDiffY -= event.y;
+        }
+        break;
+
+        case InputEventResize:
+        {
+            width = event.x;
+            height = event.y;
+
+            isResizedInCurrentFrame = true;
+        }
+        break;
+    }
+}
+
+void OpenGLApp::requestRedraw()
+{
+    _redrawRequested = true;
+
+    if (Wake)
+    {
+        Wake();
+    }
+}
+
+void OpenGLApp::ageInput()
+{
+    ageStates(KeyStates, _changedKeys, _pendingKeyReleases);
+    ageStates(ButtonStates, _changedButtons, _pendingButtonReleases);
+
+    inputEvents.clear();
+    isResizedInCurrentFrame = false;
+
+    mouseDiffX = 0;
+    mouseDiffY = 0;
+    _cursorDiffX = 0;
+    _cursorDiffY = 0;
+    _rawMouseActive = false;
+}
+
+bool readFramebuffer(
+    const OpenGLApp &app,
+    std::vector<unsigned char> &pixels)
+{
+    PROFILE_SCOPE("readFramebuffer");
+
+    if (app.width <= 0 || app.height <= 0)
+    {
+        spdlog::error("cannot read back a framebuffer of {}x{}", app.width, app.height);
+
+        return false;
+    }
+
+    pixels.resize(static_cast<size_t>(app.width) * app.height * 4);
+
+    GLint samples = 0;
+    glGetNamedFramebufferParameteriv(app.framebuffer, GL_SAMPLES, &samples);
+
+    // A multisampled framebuffer cannot be read directly, it is resolved into a temporary one first
+    GLuint resolveFramebuffer = 0;
+    GLuint resolveRenderbuffer = 0;
+
+    if (samples > 0)
+    {
+        glCreateRenderbuffers(1, &resolveRenderbuffer);
+        glNamedRenderbufferStorage(resolveRenderbuffer, GL_RGBA8, app.width, app.height);
+
+        glCreateFramebuffers(1, &resolveFramebuffer);
+        glNamedFramebufferRenderbuffer(resolveFramebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRenderbuffer);
+
+        glBlitNamedFramebuffer(
+            app.framebuffer,
+            resolveFramebuffer,
+            0, 0, app.width, app.height,
+            0, 0, app.width, app.height,
+            GL_COLOR_BUFFER_BIT,
+            GL_NEAREST);
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+
+    // The pixels go to client memory, which a bound pack buffer would turn into an offset into it
+    GLint previousPackBuffer = 0;
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previousPackBuffer);
+
+    GLint previousPackAlignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousPackAlignment);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, samples > 0 ? resolveFramebuffer : app.framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, app.width, app.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, previousPackAlignment);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, previousPackBuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+
+    if (samples > 0)
+    {
+        glDeleteFramebuffers(1, &resolveFramebuffer);
+        glDeleteRenderbuffers(1, &resolveRenderbuffer);
+    }
+
+    return true;
+}
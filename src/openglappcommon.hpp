@@ -0,0 +1,42 @@
+#ifndef OPENGLAPPCOMMON_HPP
+#define OPENGLAPPCOMMON_HPP
+
+#include <glad/glad.h>
+
+#include <deque>
+#include <framelimiter.hpp>
+#include <functional>
+#include <openglapp.hpp>
+
+// What the window system backends of openApp and embedApp have in common
+
+/// Fence the frame that was just submitted and wait until the GPU caught up to at most maxFramesInFlight frames.
+void limitFramesInFlight(
+    std::deque<GLsync> &fences,
+    int maxFramesInFlight);
+
+/// The part of present after the frame was handed to the window system: limit the frames in flight,
+/// close the frame's GL call counts and capture, start the next GPU frame and run the ready callbacks
+/// of finished background uploads.
+void finishPresent(
+    OpenGLApp &app,
+    std::deque<GLsync> &fences);
+
+/// The part of GameLoop before the backend reads input: present, or hand the frame to the render
+/// thread, then pace and age the input of the last frame.
+void endAppFrame(
+    OpenGLApp &app,
+    FrameLimiter &frameLimiter);
+
+/// With onDemandRendering, block until something needs a new frame. wait blocks for at most the given
+/// milliseconds, -1 for no limit, handles whatever woke it and returns false when the app is closed.
+/// Returns false when GameLoop should end.
+bool waitForRedraw(
+    OpenGLApp &app,
+    const std::function<bool(int)> &wait);
+
+/// The part of GameLoop after the backend read input.
+void beginAppFrame(
+    OpenGLApp &app);
+
+#endif // OPENGLAPPCOMMON_HPP
@@ -0,0 +1,403 @@
+#include <openglapp.hpp>
+
+#include "gldebugoutput.hpp"
+#include "glloader.hpp"
+#include "openglappcommon.hpp"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <glcapture.hpp>
+#include <gltrace.hpp>
+#include <gpuprofiler.hpp>
+#include <memory>
+#include <mutex>
+#include <profiler.hpp>
+#include <renderthread.hpp>
+#include <resourceloader.hpp>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+// Headless backend: a surfaceless EGL context that renders into an offscreen framebuffer, for batch
+// rendering and tests on machines without a display, down to Mesa's llvmpipe on GPU-less servers.
+
+static const int defaultWidth = 1920;
+static const int defaultHeight = 1080;
+
+// There are no window system events, an on-demand GameLoop only waits for Wake and its timers
+struct Waker
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool woken = false;
+};
+
+static EGLDisplay openDisplay()
+{
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (getPlatformDisplay != nullptr)
+    {
+        auto display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+        if (display != EGL_NO_DISPLAY)
+        {
+            return display;
+        }
+    }
+
+    spdlog::warn("surfaceless egl platform is not available, using the default display");
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static EGLContext createContext(
+    EGLDisplay display,
+    EGLConfig config,
+    EGLContext shareContext,
+    const ContextOptions &options)
+{
+    auto extensions = std::string_view(eglQueryString(display, EGL_EXTENSIONS));
+    auto noError = options.noError && extensions.find("EGL_KHR_create_context_no_error") != std::string_view::npos;
+
+    if (options.noError && !noError && shareContext == EGL_NO_CONTEXT)
+    {
+        spdlog::warn("EGL_KHR_create_context_no_error is not supported, errors are still checked");
+    }
+
+    // llvmpipe tops out at 4.5, which has everything but SPIR-V shaders
+    const EGLint versions[][2] = {{4, 6}, {4, 5}};
+
+    for (auto &version : versions)
+    {
+        EGLint attribList[] =
+            {
+                EGL_CONTEXT_MAJOR_VERSION,
+                version[0],
+                EGL_CONTEXT_MINOR_VERSION,
+                version[1],
+                EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                options.coreProfile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+                noError ? EGL_CONTEXT_OPENGL_NO_ERROR_KHR : EGL_NONE,
+                EGL_TRUE,
+                EGL_NONE,
+            };
+
+        auto context = eglCreateContext(display, config, shareContext, attribList);
+
+        if (context != EGL_NO_CONTEXT)
+        {
+            if (shareContext == EGL_NO_CONTEXT)
+            {
+                spdlog::info("created headless opengl {}.{} context", version[0], version[1]);
+            }
+
+            return context;
+        }
+    }
+
+    return EGL_NO_CONTEXT;
+}
+
+// The offscreen framebuffer takes the format the window system would give the default framebuffer
+static bool createFramebuffer(
+    OpenGLApp &app,
+    GLuint renderbuffers[2])
+{
+    const auto &options = app.contextOptions;
+    auto samples = std::max(options.samples, 0);
+
+    glCreateRenderbuffers(2, renderbuffers);
+    glNamedRenderbufferStorageMultisample(renderbuffers[0], samples, options.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, app.width, app.height);
+
+    glCreateFramebuffers(1, &app.framebuffer);
+    glNamedFramebufferRenderbuffer(app.framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+
+    if (options.depthStencil != DepthStencilFormatNone)
+    {
+        GLenum format = GL_DEPTH_COMPONENT24;
+        GLenum attachment = GL_DEPTH_ATTACHMENT;
+
+        if (options.depthStencil == DepthStencilFormatDepth16)
+        {
+            format = GL_DEPTH_COMPONENT16;
+        }
+        else if (options.depthStencil == DepthStencilFormatDepth24Stencil8)
+        {
+            format = GL_DEPTH24_STENCIL8;
+            attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+        }
+
+        glNamedRenderbufferStorageMultisample(renderbuffers[1], samples, format, app.width, app.height);
+        glNamedFramebufferRenderbuffer(app.framebuffer, attachment, GL_RENDERBUFFER, renderbuffers[1]);
+    }
+
+    if (glCheckNamedFramebufferStatus(app.framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        spdlog::error("offscreen framebuffer of {}x{} with {} samples is incomplete", app.width, app.height, samples);
+
+        return false;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
+
+    return true;
+}
+
+bool openApp(
+    OpenGLApp &app)
+{
+    PROFILE_SCOPE("openApp");
+
+    setProfileThreadName("main");
+
+    auto display = openDisplay();
+
+    EGLint major = 0, minor = 0;
+
+    if (display == EGL_NO_DISPLAY || eglInitialize(display, &major, &minor) == EGL_FALSE)
+    {
+        spdlog::error("failed to initialize egl display");
+
+        return false;
+    }
+
+    if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+    {
+        spdlog::error("egl {}.{} does not support desktop opengl", major, minor);
+
+        eglTerminate(display);
+
+        return false;
+    }
+
+    // No surface is ever created, any surface type will do
+    const EGLint configAttribs[] =
+        {
+            EGL_RENDERABLE_TYPE,
+            EGL_OPENGL_BIT,
+            EGL_SURFACE_TYPE,
+            EGL_DONT_CARE,
+            EGL_NONE,
+        };
+
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+
+    if (eglChooseConfig(display, configAttribs, &config, 1, &configCount) == EGL_FALSE || configCount == 0)
+    {
+        spdlog::error("failed to choose egl config");
+
+        eglTerminate(display);
+
+        return false;
+    }
+
+    auto context = createContext(display, config, EGL_NO_CONTEXT, app.contextOptions);
+
+    if (context == EGL_NO_CONTEXT)
+    {
+        spdlog::error("failed to create opengl 4.5 or newer context");
+
+        eglTerminate(display);
+
+        return false;
+    }
+
+    if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE)
+    {
+        spdlog::error("failed to make context current without a surface");
+
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+
+        return false;
+    }
+
+    if (!loadOpenGl(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+    {
+        spdlog::error("failed to load opengl functions");
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+
+        return false;
+    }
+
+    enableOpenGlDebug(app.debugOutput);
+
+    if (app.countGlCalls)
+    {
+        glTrace().setEnabled(true);
+    }
+
+    EGLContext loaderContext = EGL_NO_CONTEXT;
+
+    if (app.backgroundLoading)
+    {
+        loaderContext = createContext(display, config, context, app.contextOptions);
+
+        if (loaderContext == EGL_NO_CONTEXT)
+        {
+            spdlog::error("failed to create shared loader context, uploads stay on the main context");
+        }
+    }
+
+    if (app.width <= 0 || app.height <= 0)
+    {
+        app.width = defaultWidth;
+        app.height = defaultHeight;
+    }
+
+    auto renderbuffers = std::make_shared<std::array<GLuint, 2>>();
+
+    if (!createFramebuffer(app, renderbuffers->data()))
+    {
+        glTrace().setEnabled(false);
+        shutdownOpenGlDebug();
+
+        glDeleteFramebuffers(1, &app.framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers->data());
+        app.framebuffer = 0;
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (loaderContext != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(display, loaderContext);
+        }
+
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+
+        return false;
+    }
+
+    glViewport(0, 0, app.width, app.height);
+
+    spdlog::info("headless {}x{} framebuffer created", app.width, app.height);
+
+    // The replay creates its own framebuffer, the capture starts right after this one
+    if (!app.glCapturePath.empty())
+    {
+        glCapture().start(app.glCapturePath, app.glCaptureFrames, app.width, app.height, app.framebuffer);
+    }
+
+    app.MakeCurrent = [display, context](bool current) -> bool {
+        return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, current ? context : EGL_NO_CONTEXT) != EGL_FALSE;
+    };
+
+    if (loaderContext != EGL_NO_CONTEXT)
+    {
+        app.MakeLoaderCurrent = [display, loaderContext](bool current) -> bool {
+            return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, current ? loaderContext : EGL_NO_CONTEXT) != EGL_FALSE;
+        };
+    }
+
+    // There is nothing to swap and no display to sync to, the swap interval does not apply
+    app.Present = [app = &app, fences = std::deque<GLsync>()]() mutable {
+        gpuProfiler().endFrame();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, app->framebuffer);
+
+        finishPresent(*app, fences);
+    };
+
+    auto waker = std::make_shared<Waker>();
+
+    app.Wake = [waker]() {
+        {
+            std::lock_guard<std::mutex> lock(waker->mutex);
+
+            waker->woken = true;
+        }
+
+        waker->condition.notify_one();
+    };
+
+    app.GameLoop = [app = &app, waker, frameLimiter = std::make_shared<FrameLimiter>()]() -> bool {
+        if (app->quit)
+        {
+            return false;
+        }
+
+        endAppFrame(*app, *frameLimiter);
+
+        auto waitForWake = [waker](int timeout) -> bool {
+            std::unique_lock<std::mutex> lock(waker->mutex);
+
+            if (timeout < 0)
+            {
+                waker->condition.wait(lock, [waker]() { return waker->woken; });
+            }
+            else
+            {
+                waker->condition.wait_for(lock, std::chrono::milliseconds(timeout), [waker]() { return waker->woken; });
+            }
+
+            waker->woken = false;
+
+            return true;
+        };
+
+        if (!waitForRedraw(*app, waitForWake))
+        {
+            return false;
+        }
+
+        beginAppFrame(*app);
+
+        return true;
+    };
+
+    app.Cleanup = [app = &app, display, context, loaderContext, renderbuffers]() -> int {
+        if (app->renderThread != nullptr)
+        {
+            app->renderThread->stop();
+        }
+
+        if (app->resourceLoader != nullptr)
+        {
+            app->resourceLoader->stop();
+        }
+
+        glCapture().stop();
+        glTrace().stopRecording();
+        glTrace().setEnabled(false);
+        gpuProfiler().shutdown();
+        shutdownOpenGlDebug();
+
+        logOpenGlLoaderStats();
+
+        glDeleteFramebuffers(1, &app->framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers->data());
+        app->framebuffer = 0;
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (loaderContext != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(display, loaderContext);
+        }
+
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+
+        return 0;
+    };
+
+    return true;
+}
+
+bool embedApp(
+    long window,
+    OpenGLApp &app)
+{
+    (void)window;
+
+    spdlog::warn("the headless backend has no window to embed into, rendering offscreen instead");
+
+    return openApp(app);
+}
@@ -0,0 +1,198 @@
+#include <profiler.hpp>
+
+#include "jsonwriter.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <spdlog/spdlog.h>
+
+static const size_t profileBufferSize = 1 << 15;
+
+// Written by its own thread only; readers validate what they copied against the write counter
+// afterwards instead of taking a lock.
+struct ProfileThreadBuffer
+{
+    uint32_t threadId = 0;
+    std::string threadName;
+    std::atomic<uint64_t> written = 0;
+    std::array<ProfileEvent, profileBufferSize> events;
+};
+
+static std::mutex &registryMutex()
+{
+    static std::mutex mutex;
+
+    return mutex;
+}
+
+static std::vector<std::shared_ptr<ProfileThreadBuffer>> &registry()
+{
+    static std::vector<std::shared_ptr<ProfileThreadBuffer>> buffers;
+
+    return buffers;
+}
+
+static ProfileThreadBuffer &threadBuffer()
+{
+    // Registering takes the lock once per thread, recording never does
+    thread_local std::shared_ptr<ProfileThreadBuffer> buffer;
+
+    if (buffer == nullptr)
+    {
+        buffer = std::make_shared<ProfileThreadBuffer>();
+
+        std::lock_guard<std::mutex> lock(registryMutex());
+
+        buffer->threadId = static_cast<uint32_t>(registry().size() + 1);
+        buffer->threadName = "thread " + std::to_string(buffer->threadId);
+
+        registry().push_back(buffer);
+    }
+
+    return *buffer;
+}
+
+uint64_t profileNow()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void setProfileThreadName(
+    const char *name)
+{
+    auto &buffer = threadBuffer();
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+
+    buffer.threadName = name;
+}
+
+void recordProfileEvent(
+    const char *name,
+    uint64_t begin,
+    uint64_t end)
+{
+    auto &buffer = threadBuffer();
+    auto written = buffer.written.load(std::memory_order_relaxed);
+
+    buffer.events[written % profileBufferSize] = {name, begin, end};
+    buffer.written.store(written + 1, std::memory_order_release);
+}
+
+std::vector<ProfileThreadEvents> collectProfileEvents(
+    uint64_t since)
+{
+    std::vector<std::shared_ptr<ProfileThreadBuffer>> buffers;
+    std::vector<ProfileThreadEvents> threads;
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+
+        buffers = registry();
+
+        for (auto &buffer : buffers)
+        {
+            threads.push_back({buffer->threadId, buffer->threadName, {}, {}});
+        }
+    }
+
+    for (size_t i = 0; i < buffers.size(); i++)
+    {
+        auto &buffer = *buffers[i];
+        auto &events = threads[i].events;
+
+        auto written = buffer.written.load(std::memory_order_acquire);
+        auto first = written > profileBufferSize ? written - profileBufferSize : 0;
+
+        for (auto n = first; n < written; n++)
+        {
+            events.push_back(buffer.events[n % profileBufferSize]);
+        }
+
+        // Whatever the writer overwrote while we were copying, including the slot it may be writing
+        // right now, can be torn, drop it
+        auto writtenAfter = buffer.written.load(std::memory_order_acquire) + 1;
+        auto valid = writtenAfter > profileBufferSize ? writtenAfter - profileBufferSize : 0;
+
+        if (valid > first)
+        {
+            events.erase(events.begin(), events.begin() + std::min<size_t>(valid - first, events.size()));
+        }
+
+        std::erase_if(events, [since](const ProfileEvent &event) { return event.end < since; });
+    }
+
+    return threads;
+}
+
+bool writeChromeTrace(
+    const std::string &path,
+    const std::vector<ProfileThreadEvents> &threads)
+{
+    std::ofstream file(path);
+
+    if (!file.is_open())
+    {
+        spdlog::error("failed to open {} for writing", path);
+
+        return false;
+    }
+
+    // Timestamps count from the first profileNow(), the default 6 significant digits would lose
+    // microseconds after a second and milliseconds after a few minutes
+    file << std::fixed << std::setprecision(3);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+
+    for (auto &thread : threads)
+    {
+        file << (first ? "" : ",\n")
+             << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread.threadId
+             << ",\"args\":{\"name\":";
+        writeJsonString(file, thread.threadName);
+        file << "}}";
+
+        first = false;
+
+        for (auto &event : thread.events)
+        {
+            // Chrome trace timestamps are in microseconds
+            file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadId
+                 << ",\"ts\":" << event.begin / 1000.0
+                 << ",\"dur\":" << (event.end - event.begin) / 1000.0
+                 << ",\"name\":";
+            writeJsonString(file, event.name);
+            file << "}";
+        }
+
+        for (auto &counter : thread.counters)
+        {
+            file << ",\n{\"ph\":\"C\",\"pid\":1,\"tid\":" << thread.threadId
+                 << ",\"ts\":" << counter.time / 1000.0
+                 << ",\"name\":";
+            writeJsonString(file, counter.name);
+            file << ",\"args\":{\"value\":" << counter.value << "}}";
+        }
+    }
+
+    file << "\n]}\n";
+
+    spdlog::info("wrote profile trace to {}", path);
+
+    return true;
+}
+
+bool dumpProfile(
+    const std::string &path)
+{
+    return writeChromeTrace(path, collectProfileEvents());
+}
@@ -3,24 +3,25 @@
 #include <shader.hpp>
 #include <vertexbuffer.hpp>
 
+#include <charconv>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <spdlog/spdlog.h>
-
-int main(
-    int argc,
-    const char *argv[])
+#include <triangle.frag.glsl.hpp>
+#include <triangle.vert.glsl.hpp>
+
+#ifdef PLAYGROUND_PLAYER_SPIRV
+#include <triangle.frag.hpp>
+#include <triangle.vert.hpp>
+#endif
+
+// Owns the player's GL objects, they delete their names when they go out of scope here, while the
+// context is still current
+static int run(
+    OpenGLApp &app,
+    int frames)
 {
-    spdlog::set_level(spdlog::level::debug);
-
-    OpenGLApp app;
-
-    app.title = "Playground";
-    app.width = 800;
-    app.height = 640;
-
-    if (!openApp(app)) return 1;
-
     struct Vertex
     {
         float pos[3];
@@ -55,26 +56,17 @@ int main(
 
     Shader shdr;
 
-    const char *vs = GLSL460(
-        layout(location = 0) in vec3 pos;
-        layout(location = 1) in vec2 uv;
-
-        uniform mat4 u_proj;
-        uniform mat4 u_view;
-        uniform mat4 u_model;
-
-        void main() {
-            gl_Position = u_proj * u_view * u_model * vec4(pos.x, pos.y, pos.z, 1.0);
-        });
+    bool loaded = false;
 
-    const char *fs = GLSL460(
-        layout(location = 0) out vec4 color;
-
-        void main() {
-            color = vec4(1.0, 0.0, 0.0, 1.0);
-        });
+#ifdef PLAYGROUND_PLAYER_SPIRV
+    // Without GL 4.6 or GL_ARB_gl_spirv the same shaders are compiled from their GLSL instead
+    if (GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_gl_spirv)
+    {
+        loaded = shdr.loadSpirv(triangle_vert, triangle_frag);
+    }
+#endif
 
-    if (!shdr.compile(vs, fs))
+    if (!loaded && !shdr.compile(triangle_vert_glsl, triangle_frag_glsl))
     {
         spdlog::error("failed to compile shader");
 
@@ -105,7 +97,52 @@ int main(
         shdr.bind();
         vb.bind();
         glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        if (frames > 0 && --frames == 0)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+// playground-player [frames to render before quitting, until Escape by default]
+//
+// With a frame count the player runs unattended, like on the headless backend in a batch job.
+
+int main(
+    int argc,
+    const char *argv[])
+{
+    spdlog::set_level(spdlog::level::debug);
+
+    int frames = 0;
+
+    if (argc > 1)
+    {
+        const char *end = argv[1] + std::strlen(argv[1]);
+        auto [parsed, error] = std::from_chars(argv[1], end, frames);
+
+        if (error != std::errc() || parsed != end || frames < 0)
+        {
+            spdlog::error("usage: {} [frames]", argv[0]);
+
+            return 1;
+        }
     }
 
-    return app.Cleanup();
+    OpenGLApp app;
+
+    app.title = "Playground";
+    app.width = 800;
+    app.height = 640;
+
+    if (!openApp(app)) return 1;
+
+    int result = run(app, frames);
+
+    int cleanupResult = app.Cleanup();
+
+    return result != 0 ? result : cleanupResult;
 }
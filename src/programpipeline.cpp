@@ -0,0 +1,85 @@
+#include <programpipeline.hpp>
+
+#include <spdlog/spdlog.h>
+#include <vector>
+
+ProgramPipeline::ProgramPipeline() = default;
+
+ProgramPipeline::~ProgramPipeline()
+{
+    if (_pipelineId != 0)
+    {
+        glDeleteProgramPipelines(1, &_pipelineId);
+    }
+}
+
+GLuint ProgramPipeline::id() const
+{
+    return _pipelineId;
+}
+
+void ProgramPipeline::bind() const
+{
+    // A hot reload swaps the program of a stage, the pipeline still points at the deleted one
+    if (_vertStage != nullptr && (_vertStage->id() != _vertProgram || _fragStage->id() != _fragProgram))
+    {
+        useStages();
+    }
+
+    glUseProgram(0);
+    glBindProgramPipeline(_pipelineId);
+}
+
+bool ProgramPipeline::validate() const
+{
+    GLint result = GL_FALSE;
+    GLint logLength = 0;
+
+    glValidateProgramPipeline(_pipelineId);
+
+    glGetProgramPipelineiv(_pipelineId, GL_VALIDATE_STATUS, &result);
+    if (result == GL_FALSE)
+    {
+        glGetProgramPipelineiv(_pipelineId, GL_INFO_LOG_LENGTH, &logLength);
+        std::vector<char> pipelineError(static_cast<size_t>((logLength > 1) ? logLength : 1));
+        glGetProgramPipelineInfoLog(_pipelineId, static_cast<GLsizei>(pipelineError.size()), NULL, &pipelineError[0]);
+        spdlog::error("error validating program pipeline ({} bytes of log): {}", logLength, pipelineError.data());
+
+        return false;
+    }
+
+    return true;
+}
+
+bool ProgramPipeline::setup(
+    const Shader &vertStage,
+    const Shader &fragStage)
+{
+    if ((vertStage.stages() & GL_VERTEX_SHADER_BIT) == 0 || (fragStage.stages() & GL_FRAGMENT_SHADER_BIT) == 0)
+    {
+        spdlog::error("program pipeline needs a separable vertex and fragment stage");
+
+        return false;
+    }
+
+    if (_pipelineId == 0)
+    {
+        glCreateProgramPipelines(1, &_pipelineId);
+    }
+
+    _vertStage = &vertStage;
+    _fragStage = &fragStage;
+
+    useStages();
+
+    return true;
+}
+
+void ProgramPipeline::useStages() const
+{
+    _vertProgram = _vertStage->id();
+    _fragProgram = _fragStage->id();
+
+    glUseProgramStages(_pipelineId, GL_VERTEX_SHADER_BIT, _vertProgram);
+    glUseProgramStages(_pipelineId, GL_FRAGMENT_SHADER_BIT, _fragProgram);
+}
@@ -0,0 +1,240 @@
+#include <renderthread.hpp>
+
+#include <openglapp.hpp>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+
+RenderThread::RenderThread() = default;
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+bool RenderThread::start(
+    OpenGLApp &app)
+{
+    if (isRunning())
+    {
+        return true;
+    }
+
+    if (!app.MakeCurrent || !app.Present)
+    {
+        spdlog::error("the app has no context to hand to a render thread");
+
+        return false;
+    }
+
+    if (!app.MakeCurrent(false))
+    {
+        spdlog::error("failed to release the render context on the main thread");
+
+        return false;
+    }
+
+    _app = &app;
+    _started = false;
+    _failed = false;
+    _stop = false;
+    _hasFrame = false;
+    _thread = std::thread(&RenderThread::run, this);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _condition.wait(lock, [this]() { return _started || _failed; });
+
+    if (_failed)
+    {
+        lock.unlock();
+
+        _thread.join();
+        _app->MakeCurrent(true);
+        _app = nullptr;
+
+        return false;
+    }
+
+    app.renderThread = this;
+
+    spdlog::info("render thread started");
+
+    return true;
+}
+
+void RenderThread::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stop = true;
+    }
+
+    _condition.notify_all();
+    _thread.join();
+
+    _app->renderThread = nullptr;
+
+    if (!_app->MakeCurrent(true))
+    {
+        spdlog::error("failed to make the render context current on the main thread again");
+    }
+
+    // Whatever was recorded after the last frame still runs, now on the main thread
+    for (auto &command : _recording)
+    {
+        command();
+    }
+
+    _recording.clear();
+    _app = nullptr;
+
+    spdlog::info("render thread stopped");
+}
+
+bool RenderThread::isRunning() const
+{
+    return _thread.joinable();
+}
+
+void RenderThread::submit(
+    Command command)
+{
+    if (!isRunning())
+    {
+        command();
+
+        return;
+    }
+
+    _recording.push_back(std::move(command));
+}
+
+void RenderThread::runAndWait(
+    Command command)
+{
+    if (!isRunning())
+    {
+        command();
+
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _immediate.push_back(std::move(command));
+
+    auto ticket = ++_immediateQueued;
+
+    _condition.notify_all();
+    _condition.wait(lock, [this, ticket]() { return _immediateDone >= ticket; });
+}
+
+void RenderThread::endFrame()
+{
+    PROFILE_SCOPE("RenderThread::endFrame");
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // Only one frame is in flight on the render thread, this is where the main thread waits when it is ahead
+    _condition.wait(lock, [this]() { return !_hasFrame; });
+
+    std::swap(_recording, _submitted);
+    _recording.clear();
+    _hasFrame = true;
+
+    lock.unlock();
+
+    _condition.notify_all();
+}
+
+void RenderThread::run()
+{
+    setProfileThreadName("render");
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (!_app->MakeCurrent(true))
+    {
+        spdlog::error("failed to make the render context current on the render thread");
+
+        _failed = true;
+        _condition.notify_all();
+
+        return;
+    }
+
+    _started = true;
+    _condition.notify_all();
+
+    while (true)
+    {
+        _condition.wait(lock, [this]() { return _hasFrame || _stop || !_immediate.empty(); });
+
+        runImmediate(lock);
+
+        if (_hasFrame)
+        {
+            // The main thread does not touch the submitted list until _hasFrame is cleared
+            lock.unlock();
+
+            {
+                PROFILE_SCOPE("render frame");
+
+                for (auto &command : _submitted)
+                {
+                    command();
+                }
+
+                _submitted.clear();
+            }
+
+            _app->Present();
+
+            lock.lock();
+
+            _hasFrame = false;
+            _condition.notify_all();
+
+            continue;
+        }
+
+        if (_stop)
+        {
+            break;
+        }
+    }
+
+    runImmediate(lock);
+
+    _app->MakeCurrent(false);
+}
+
+void RenderThread::runImmediate(
+    std::unique_lock<std::mutex> &lock)
+{
+    if (_immediate.empty())
+    {
+        return;
+    }
+
+    std::vector<Command> commands;
+    std::swap(commands, _immediate);
+
+    lock.unlock();
+
+    for (auto &command : commands)
+    {
+        command();
+    }
+
+    lock.lock();
+
+    _immediateDone += commands.size();
+    _condition.notify_all();
+}
@@ -0,0 +1,108 @@
+#include "glreplay.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <openglapp.hpp>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+// Re-issues the GL calls of a capture OpenGLApp::glCapturePath wrote, on the headless backend on
+// Linux, and times every frame. The last frame is repeated to get timings stable enough to compare
+// drivers or content against each other.
+//
+// playground-replay <capture> [repeats of the last frame, 100 by default]
+
+static double percentile(
+    std::vector<double> times,
+    double fraction)
+{
+    std::sort(times.begin(), times.end());
+
+    return times[static_cast<size_t>(fraction * (times.size() - 1))];
+}
+
+int main(
+    int argc,
+    const char *argv[])
+{
+    if (argc < 2)
+    {
+        spdlog::error("usage: {} <capture> [repeats]", argv[0]);
+
+        return 1;
+    }
+
+    int repeats = 100;
+
+    if (argc > 2)
+    {
+        const char *end = argv[2] + std::strlen(argv[2]);
+        auto [parsed, error] = std::from_chars(argv[2], end, repeats);
+
+        if (error != std::errc() || parsed != end || repeats < 0)
+        {
+            spdlog::error("usage: {} <capture> [repeats]", argv[0]);
+
+            return 1;
+        }
+    }
+
+    GlReplay replay;
+
+    // The capture is read before there is a context, GlReplay only touches GL once it replays
+    if (!replay.load(argv[1]))
+    {
+        return 1;
+    }
+
+    OpenGLApp app;
+
+    app.title = "Playground replay";
+    app.width = replay.width();
+    app.height = replay.height();
+
+    if (!openApp(app)) return 1;
+
+    replay.setFramebuffer(app.framebuffer);
+
+    spdlog::info("{:>6} {:>8} {:>8} {:>10} {:>10}", "frame", "calls", "skipped", "cpu (ms)", "gpu (ms)");
+
+    GlReplayFrame frame;
+    int frames = 0;
+
+    while (replay.replayFrame(frame))
+    {
+        spdlog::info("{:>6} {:>8} {:>8} {:>10.3f} {:>10.3f}", frames, frame.calls, frame.skipped, frame.cpuTime * 1000.0, frame.gpuTime * 1000.0);
+
+        frames++;
+    }
+
+    if (frames > 0 && repeats > 0)
+    {
+        std::vector<double> cpuTimes, gpuTimes;
+
+        for (int i = 0; i < repeats; i++)
+        {
+            replay.repeatFrame();
+
+            if (!replay.replayFrame(frame))
+            {
+                break;
+            }
+
+            cpuTimes.push_back(frame.cpuTime * 1000.0);
+            gpuTimes.push_back(frame.gpuTime * 1000.0);
+        }
+
+        if (!cpuTimes.empty())
+        {
+            spdlog::info("last frame repeated {} times, {} calls", cpuTimes.size(), frame.calls);
+            spdlog::info("{:>8} {:>10} {:>10} {:>10}", "", "min (ms)", "p50 (ms)", "max (ms)");
+            spdlog::info("{:>8} {:>10.3f} {:>10.3f} {:>10.3f}", "cpu", percentile(cpuTimes, 0.0), percentile(cpuTimes, 0.5), percentile(cpuTimes, 1.0));
+            spdlog::info("{:>8} {:>10.3f} {:>10.3f} {:>10.3f}", "gpu", percentile(gpuTimes, 0.0), percentile(gpuTimes, 0.5), percentile(gpuTimes, 1.0));
+        }
+    }
+
+    return app.Cleanup();
+}
@@ -0,0 +1,209 @@
+#include <resourceloader.hpp>
+
+#include <openglapp.hpp>
+#include <profiler.hpp>
+#include <spdlog/spdlog.h>
+
+ResourceLoader::ResourceLoader() = default;
+
+ResourceLoader::~ResourceLoader()
+{
+    stop();
+}
+
+bool ResourceLoader::start(
+    OpenGLApp &app)
+{
+    if (isRunning())
+    {
+        return true;
+    }
+
+    if (!app.MakeLoaderCurrent)
+    {
+        spdlog::error("the app has no loader context, enable backgroundLoading before opening it");
+
+        return false;
+    }
+
+    _app = &app;
+    _started = false;
+    _failed = false;
+    _stop = false;
+    _thread = std::thread(&ResourceLoader::run, this);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _condition.wait(lock, [this]() { return _started || _failed; });
+
+    if (_failed)
+    {
+        lock.unlock();
+
+        _thread.join();
+        _app = nullptr;
+
+        return false;
+    }
+
+    app.resourceLoader = this;
+
+    return true;
+}
+
+void ResourceLoader::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stop = true;
+    }
+
+    _condition.notify_all();
+    _thread.join();
+
+    _app->resourceLoader = nullptr;
+    _app = nullptr;
+
+    // Sync objects are shared, so the presenting context can delete the fences the loader created
+    for (auto &upload : _uploaded)
+    {
+        glDeleteSync(upload.fence);
+    }
+
+    _uploaded.clear();
+    _pending = 0;
+}
+
+bool ResourceLoader::isRunning() const
+{
+    return _thread.joinable();
+}
+
+void ResourceLoader::load(
+    Task upload,
+    Task ready)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _queued.push_back({std::move(upload), std::move(ready)});
+        _pending++;
+    }
+
+    _condition.notify_one();
+}
+
+void ResourceLoader::update()
+{
+    std::vector<Upload> finished;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (size_t i = 0; i < _uploaded.size();)
+        {
+            // A zero timeout only polls, the frame never waits for an upload
+            auto status = glClientWaitSync(_uploaded[i].fence, 0, 0);
+
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+            {
+                if (status == GL_WAIT_FAILED)
+                {
+                    spdlog::error("failed to check upload fence");
+                }
+
+                finished.push_back(std::move(_uploaded[i]));
+                _uploaded.erase(_uploaded.begin() + i);
+
+                continue;
+            }
+
+            i++;
+        }
+
+        _pending -= finished.size();
+    }
+
+    if (finished.empty())
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("ResourceLoader::update");
+
+    for (auto &upload : finished)
+    {
+        glDeleteSync(upload.fence);
+
+        if (upload.ready)
+        {
+            upload.ready();
+        }
+    }
+}
+
+size_t ResourceLoader::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _pending;
+}
+
+void ResourceLoader::run()
+{
+    setProfileThreadName("loader");
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (!_app->MakeLoaderCurrent(true))
+    {
+        spdlog::error("failed to make the loader context current");
+
+        _failed = true;
+        _condition.notify_all();
+
+        return;
+    }
+
+    _started = true;
+    _condition.notify_all();
+
+    while (true)
+    {
+        _condition.wait(lock, [this]() { return _stop || !_queued.empty(); });
+
+        if (_queued.empty())
+        {
+            break;
+        }
+
+        auto upload = std::move(_queued.front());
+        _queued.pop_front();
+
+        lock.unlock();
+
+        {
+            PROFILE_SCOPE("ResourceLoader upload");
+
+            upload.upload();
+        }
+
+        // Flushing gets the commands and the fence to the GPU, the presenting context only polls it
+        upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        lock.lock();
+
+        _uploaded.push_back(std::move(upload));
+    }
+
+    lock.unlock();
+
+    _app->MakeLoaderCurrent(false);
+}
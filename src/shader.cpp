@@ -1,11 +1,15 @@
 #include <shader.hpp>
 
 #include <glm/gtc/type_ptr.hpp>
+#include <profiler.hpp>
 #include <spdlog/spdlog.h>
 
 Shader::Shader() = default;
 
-Shader::~Shader() = default;
+Shader::~Shader()
+{
+    deleteProgram();
+}
 
 GLuint Shader::id() const
 {
@@ -17,79 +21,575 @@ void Shader::bind() const
     glUseProgram(_shaderId);
 }
 
-bool Shader::compile(
-    const std::string &vertShaderStr,
-    const std::string &fragShaderStr)
+static const char *stageName(
+    GLenum type)
 {
-    GLuint vertShader = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragShader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char *vertShaderSrc = vertShaderStr.c_str();
-    const char *fragShaderSrc = fragShaderStr.c_str();
+    switch (type)
+    {
+        case GL_VERTEX_SHADER:
+            return "vertex";
+        case GL_FRAGMENT_SHADER:
+            return "fragment";
+        case GL_COMPUTE_SHADER:
+            return "compute";
+        case GL_GEOMETRY_SHADER:
+            return "geometry";
+        case GL_TESS_CONTROL_SHADER:
+            return "tessellation control";
+        case GL_TESS_EVALUATION_SHADER:
+            return "tessellation evaluation";
+    }
 
+    return "unknown";
+}
+
+static GLbitfield stageShaderBit(
+    GLenum type)
+{
+    switch (type)
+    {
+        case GL_VERTEX_SHADER:
+            return GL_VERTEX_SHADER_BIT;
+        case GL_FRAGMENT_SHADER:
+            return GL_FRAGMENT_SHADER_BIT;
+        case GL_GEOMETRY_SHADER:
+            return GL_GEOMETRY_SHADER_BIT;
+        case GL_TESS_CONTROL_SHADER:
+            return GL_TESS_CONTROL_SHADER_BIT;
+        case GL_TESS_EVALUATION_SHADER:
+            return GL_TESS_EVALUATION_SHADER_BIT;
+        case GL_COMPUTE_SHADER:
+            return GL_COMPUTE_SHADER_BIT;
+    }
+
+    return 0;
+}
+
+static bool checkCompileStatus(
+    GLuint shader,
+    GLenum type)
+{
     GLint result = GL_FALSE;
     GLint logLength;
 
-    // Compile vertex shader
-    glShaderSource(vertShader, 1, &vertShaderSrc, NULL);
-    glCompileShader(vertShader);
-
-    // Check vertex shader
-    glGetShaderiv(vertShader, GL_COMPILE_STATUS, &result);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE)
     {
-        glGetShaderiv(vertShader, GL_INFO_LOG_LENGTH, &logLength);
-        std::vector<char> vertShaderError(static_cast<size_t>((logLength > 1) ? logLength : 1));
-        glGetShaderInfoLog(vertShader, logLength, NULL, &vertShaderError[0]);
-        spdlog::error("error compiling vertex shader: {}", vertShaderError.data());
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        std::vector<char> shaderError(static_cast<size_t>((logLength > 1) ? logLength : 1));
+        glGetShaderInfoLog(shader, logLength, NULL, &shaderError[0]);
+        spdlog::error("error compiling {} shader: {}", stageName(type), shaderError.data());
 
         return false;
     }
 
-    // Compile fragment shader
-    glShaderSource(fragShader, 1, &fragShaderSrc, NULL);
-    glCompileShader(fragShader);
+    return true;
+}
 
-    // Check fragment shader
-    glGetShaderiv(fragShader, GL_COMPILE_STATUS, &result);
+static GLuint compileShaderStage(
+    GLenum type,
+    const std::string &shaderStr)
+{
+    GLuint shader = glCreateShader(type);
+    const char *shaderSrc = shaderStr.c_str();
+
+    glShaderSource(shader, 1, &shaderSrc, NULL);
+    glCompileShader(shader);
+
+    if (!checkCompileStatus(shader, type))
+    {
+        glDeleteShader(shader);
+
+        return 0;
+    }
+
+    return shader;
+}
+
+static GLuint loadSpirvStage(
+    const SpirvModule &module,
+    const SpecializationConstants &constants)
+{
+    if (!GLAD_GL_VERSION_4_6 && !GLAD_GL_ARB_gl_spirv)
+    {
+        spdlog::error("loading SPIR-V requires OpenGL 4.6 or GL_ARB_gl_spirv");
+
+        return 0;
+    }
+
+    GLuint shader = glCreateShader(module.stage);
+
+    glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, module.code, module.size);
+
+    // Only pass the constants this stage declares, the set is shared between all stages
+    std::vector<GLuint> indices, values;
+
+    for (size_t i = 0; i < module.constantCount; i++)
+    {
+        auto constant = constants.find(module.constants[i].name);
+
+        if (constant != constants.end())
+        {
+            indices.push_back(module.constants[i].id);
+            values.push_back(constant->second);
+        }
+    }
+
+    // glSpecializeShader is only loaded on 4.6 contexts, before that it comes from GL_ARB_gl_spirv
+    if (GLAD_GL_VERSION_4_6)
+    {
+        glSpecializeShader(shader, module.entryPoint, static_cast<GLuint>(indices.size()), indices.data(), values.data());
+    }
+    else
+    {
+        glSpecializeShaderARB(shader, module.entryPoint, static_cast<GLuint>(indices.size()), indices.data(), values.data());
+    }
+
+    GLint result = GL_FALSE;
+    GLint logLength;
+
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE)
+    {
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        std::vector<char> shaderError(static_cast<size_t>((logLength > 1) ? logLength : 1));
+        glGetShaderInfoLog(shader, logLength, NULL, &shaderError[0]);
+        spdlog::error("error specializing {} shader: {}", stageName(module.stage), shaderError.data());
+
+        glDeleteShader(shader);
+
+        return 0;
+    }
+
+    return shader;
+}
+
+static bool checkLinkStatus(
+    GLuint program)
+{
+    GLint result = GL_FALSE;
+    GLint logLength;
+
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
     if (result == GL_FALSE)
     {
-        glGetShaderiv(fragShader, GL_INFO_LOG_LENGTH, &logLength);
-        std::vector<char> fragShaderError(static_cast<size_t>((logLength > 1) ? logLength : 1));
-        glGetShaderInfoLog(fragShader, logLength, NULL, &fragShaderError[0]);
-        spdlog::error("error compiling fragment shader: {}", fragShaderError.data());
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        std::vector<char> programError(static_cast<size_t>((logLength > 1) ? logLength : 1));
+        glGetProgramInfoLog(program, logLength, NULL, &programError[0]);
+        spdlog::error("error linking shader: {}", programError.data());
+
+        return false;
+    }
+
+    return true;
+}
+
+bool Shader::compile(
+    const std::string &vertShaderStr,
+    const std::string &fragShaderStr)
+{
+    PROFILE_SCOPE("Shader::compile");
+
+    GLuint vertShader = compileShaderStage(GL_VERTEX_SHADER, vertShaderStr);
+    if (vertShader == 0)
+    {
+        return false;
+    }
+
+    GLuint fragShader = compileShaderStage(GL_FRAGMENT_SHADER, fragShaderStr);
+    if (fragShader == 0)
+    {
+        glDeleteShader(vertShader);
 
         return false;
     }
 
+    deleteProgram();
+
     _shaderId = glCreateProgram();
     glAttachShader(_shaderId, vertShader);
     glAttachShader(_shaderId, fragShader);
     glLinkProgram(_shaderId);
 
-    glGetProgramiv(_shaderId, GL_LINK_STATUS, &result);
-    if (result == GL_FALSE)
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+
+    if (!checkLinkStatus(_shaderId))
     {
-        glGetProgramiv(_shaderId, GL_INFO_LOG_LENGTH, &logLength);
-        std::vector<char> programError(static_cast<size_t>((logLength > 1) ? logLength : 1));
-        glGetProgramInfoLog(_shaderId, logLength, NULL, &programError[0]);
-        spdlog::error("error linking shader: {}", programError.data());
+        return false;
+    }
+
+    programChanged();
+
+    bind();
+
+    return true;
+}
+
+bool Shader::compileCompute(
+    const std::string &compShaderStr)
+{
+    PROFILE_SCOPE("Shader::compileCompute");
+
+    GLuint compShader = compileShaderStage(GL_COMPUTE_SHADER, compShaderStr);
+    if (compShader == 0)
+    {
+        return false;
+    }
+
+    deleteProgram();
+
+    _shaderId = glCreateProgram();
+    glAttachShader(_shaderId, compShader);
+    glLinkProgram(_shaderId);
+
+    glDeleteShader(compShader);
+
+    if (!checkLinkStatus(_shaderId))
+    {
+        return false;
+    }
+
+    programChanged();
+
+    bind();
+
+    return true;
+}
+
+bool Shader::compileStage(
+    GLenum stage,
+    const std::string &shaderStr)
+{
+    PROFILE_SCOPE("Shader::compileStage");
+
+    GLbitfield stageBit = stageShaderBit(stage);
+
+    if (stageBit == 0)
+    {
+        spdlog::error("unknown shader stage {}", stage);
+
+        return false;
+    }
+
+    GLuint shader = compileShaderStage(stage, shaderStr);
+    if (shader == 0)
+    {
+        return false;
+    }
+
+    deleteProgram();
+
+    _shaderId = glCreateProgram();
+    glProgramParameteri(_shaderId, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glAttachShader(_shaderId, shader);
+    glLinkProgram(_shaderId);
+    glDetachShader(_shaderId, shader);
+
+    glDeleteShader(shader);
+
+    if (!checkLinkStatus(_shaderId))
+    {
+        return false;
+    }
+
+    _stages = stageBit;
+
+    programChanged();
+
+    return true;
+}
+
+GLbitfield Shader::stages() const
+{
+    return _stages;
+}
+
+bool Shader::loadSpirv(
+    const SpirvModule &vertModule,
+    const SpirvModule &fragModule,
+    const SpecializationConstants &constants)
+{
+    PROFILE_SCOPE("Shader::loadSpirv");
+
+    GLuint vertShader = loadSpirvStage(vertModule, constants);
+    if (vertShader == 0)
+    {
+        return false;
+    }
+
+    GLuint fragShader = loadSpirvStage(fragModule, constants);
+    if (fragShader == 0)
+    {
+        glDeleteShader(vertShader);
 
         return false;
     }
 
+    deleteProgram();
+
+    _shaderId = glCreateProgram();
+    glAttachShader(_shaderId, vertShader);
+    glAttachShader(_shaderId, fragShader);
+    glLinkProgram(_shaderId);
+
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
 
+    if (!checkLinkStatus(_shaderId))
+    {
+        return false;
+    }
+
+    addSpirvUniforms(vertModule);
+    addSpirvUniforms(fragModule);
+
+    programChanged();
+
     bind();
 
     return true;
 }
 
-GLuint Shader::ensureUniformId(
-    const char *uniformName)
+bool Shader::loadSpirvCompute(
+    const SpirvModule &compModule,
+    const SpecializationConstants &constants)
 {
+    GLuint compShader = loadSpirvStage(compModule, constants);
+    if (compShader == 0)
+    {
+        return false;
+    }
+
+    deleteProgram();
+
+    _shaderId = glCreateProgram();
+    glAttachShader(_shaderId, compShader);
+    glLinkProgram(_shaderId);
+
+    glDeleteShader(compShader);
+
+    if (!checkLinkStatus(_shaderId))
+    {
+        return false;
+    }
+
+    addSpirvUniforms(compModule);
+
+    programChanged();
+
     bind();
 
+    return true;
+}
+
+void Shader::addSpirvUniforms(
+    const SpirvModule &module)
+{
+    for (size_t i = 0; i < module.uniformCount; i++)
+    {
+        _uniforms[module.uniforms[i].name].location = module.uniforms[i].location;
+    }
+}
+
+void Shader::beginReload(
+    const std::string &vertShaderStr,
+    const std::string &fragShaderStr)
+{
+    startReload({{GL_VERTEX_SHADER, vertShaderStr}, {GL_FRAGMENT_SHADER, fragShaderStr}}, 0);
+}
+
+void Shader::beginReload(
+    GLenum stage,
+    const std::string &shaderStr)
+{
+    GLbitfield stageBit = stageShaderBit(stage);
+
+    if (stageBit == 0)
+    {
+        spdlog::error("unknown shader stage {}", stage);
+
+        return;
+    }
+
+    startReload({{stage, shaderStr}}, stageBit);
+}
+
+void Shader::startReload(
+    const std::map<GLenum, std::string> &sources,
+    GLbitfield separableStages)
+{
+    // A newer source supersedes the reload that is still compiling
+    cancelReload();
+
+    for (auto &source : sources)
+    {
+        const char *shaderSrc = source.second.c_str();
+
+        GLuint shader = glCreateShader(source.first);
+        glShaderSource(shader, 1, &shaderSrc, NULL);
+        glCompileShader(shader);
+
+        _reloadShaders[source.first] = shader;
+    }
+
+    // Without checking the compile status in between, drivers with parallel shader compile can do
+    // the whole compile and link on their own threads
+    _reloadProgramId = glCreateProgram();
+
+    if (separableStages != 0)
+    {
+        glProgramParameteri(_reloadProgramId, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    }
+
+    _reloadStages = separableStages;
+
+    for (auto &shader : _reloadShaders)
+    {
+        glAttachShader(_reloadProgramId, shader.second);
+    }
+
+    glLinkProgram(_reloadProgramId);
+}
+
+bool Shader::pollReload()
+{
+    if (_reloadProgramId == 0)
+    {
+        return true;
+    }
+
+    if (GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile)
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(_reloadProgramId, GL_COMPLETION_STATUS_KHR, &completed);
+
+        if (completed == GL_FALSE)
+        {
+            return false;
+        }
+    }
+
+    bool succeeded = true;
+
+    for (auto &shader : _reloadShaders)
+    {
+        succeeded = succeeded && checkCompileStatus(shader.second, shader.first);
+    }
+
+    succeeded = succeeded && checkLinkStatus(_reloadProgramId);
+
+    for (auto &shader : _reloadShaders)
+    {
+        glDeleteShader(shader.second);
+    }
+
+    _reloadShaders.clear();
+
+    if (succeeded)
+    {
+        replaceProgram(_reloadProgramId);
+
+        _stages = _reloadStages;
+
+        spdlog::info("reloaded shader {}", _shaderId);
+    }
+    else
+    {
+        glDeleteProgram(_reloadProgramId);
+
+        spdlog::warn("keeping shader {} after failed reload", _shaderId);
+    }
+
+    _reloadProgramId = 0;
+
+    return true;
+}
+
+void Shader::cancelReload()
+{
+    if (_reloadProgramId == 0)
+    {
+        return;
+    }
+
+    glDeleteProgram(_reloadProgramId);
+
+    for (auto &shader : _reloadShaders)
+    {
+        glDeleteShader(shader.second);
+    }
+
+    _reloadProgramId = 0;
+    _reloadShaders.clear();
+}
+
+void Shader::deleteProgram()
+{
+    // A reload that is still compiling would replace the new program with the old source
+    cancelReload();
+
+    if (_shaderId != 0)
+    {
+        glDeleteProgram(_shaderId);
+    }
+
+    _shaderId = 0;
+    _stages = 0;
+    _uniforms.clear();
+}
+
+void Shader::replaceProgram(
+    GLuint programId)
+{
+    if (_shaderId != 0)
+    {
+        glDeleteProgram(_shaderId);
+    }
+
+    _shaderId = programId;
+
+    for (auto &uniform : _uniforms)
+    {
+        uniform.second.location = glGetUniformLocation(_shaderId, uniform.first.c_str());
+
+        applyUniform(uniform.second);
+    }
+
+    programChanged();
+}
+
+void Shader::programChanged()
+{}
+
+void Shader::applyUniform(
+    const Uniform &uniform)
+{
+    if (auto m = std::get_if<glm::mat4>(&uniform.value))
+    {
+        glProgramUniformMatrix4fv(_shaderId, uniform.location, 1, false, glm::value_ptr(*m));
+    }
+    else if (auto v4 = std::get_if<glm::vec4>(&uniform.value))
+    {
+        glProgramUniform4f(_shaderId, uniform.location, v4->r, v4->g, v4->b, v4->a);
+    }
+    else if (auto v3 = std::get_if<glm::vec3>(&uniform.value))
+    {
+        glProgramUniform3f(_shaderId, uniform.location, v3->x, v3->y, v3->z);
+    }
+    else if (auto i = std::get_if<int>(&uniform.value))
+    {
+        glProgramUniform1i(_shaderId, uniform.location, *i);
+    }
+    else if (auto f = std::get_if<float>(&uniform.value))
+    {
+        glProgramUniform1f(_shaderId, uniform.location, *f);
+    }
+}
+
+Shader::Uniform &Shader::ensureUniform(
+    const char *uniformName)
+{
     auto u = _uniforms.find(std::string(uniformName));
 
     if (u != _uniforms.end())
@@ -97,54 +597,58 @@ GLuint Shader::ensureUniformId(
         return u->second;
     }
 
-    auto id = glGetUniformLocation(_shaderId, uniformName);
-
-    _uniforms.insert({std::string(uniformName), id});
+    Uniform uniform;
+    uniform.location = glGetUniformLocation(_shaderId, uniformName);
 
-    return id;
+    return _uniforms.insert({std::string(uniformName), uniform}).first->second;
 }
 
 void Shader::setUniform(
     const char *uniformName,
     const glm::mat4 &m)
 {
-    auto uid = ensureUniformId(uniformName);
+    auto &uniform = ensureUniform(uniformName);
+    uniform.value = m;
 
-    glUniformMatrix4fv(uid, 1, false, glm::value_ptr(m));
+    glProgramUniformMatrix4fv(_shaderId, uniform.location, 1, false, glm::value_ptr(m));
 }
 
 void Shader::setUniform(
     const char *uniformName,
     const glm::vec4 &v)
 {
-    auto uid = ensureUniformId(uniformName);
+    auto &uniform = ensureUniform(uniformName);
+    uniform.value = v;
 
-    glUniform4f(uid, v.r, v.g, v.b, v.a);
+    glProgramUniform4f(_shaderId, uniform.location, v.r, v.g, v.b, v.a);
 }
 
 void Shader::setUniform(
     const char *uniformName,
     const glm::vec3 &v)
 {
-    auto uid = ensureUniformId(uniformName);
+    auto &uniform = ensureUniform(uniformName);
+    uniform.value = v;
 
-    glUniform3f(uid, v.x, v.y, v.z);
+    glProgramUniform3f(_shaderId, uniform.location, v.x, v.y, v.z);
 }
 
 void Shader::setUniform(
     const char *uniformName,
     int i)
 {
-    auto uid = ensureUniformId(uniformName);
+    auto &uniform = ensureUniform(uniformName);
+    uniform.value = i;
 
-    glUniform1i(uid, i);
+    glProgramUniform1i(_shaderId, uniform.location, i);
 }
 
 void Shader::setUniform(
     const char *uniformName,
     float f)
 {
-    auto uid = ensureUniformId(uniformName);
+    auto &uniform = ensureUniform(uniformName);
+    uniform.value = f;
 
-    glUniform1f(uid, f);
+    glProgramUniform1f(_shaderId, uniform.location, f);
 }
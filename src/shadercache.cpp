@@ -0,0 +1,178 @@
+#include <shadercache.hpp>
+
+#include <spdlog/spdlog.h>
+
+// 64 bit FNV-1a, stable across runs and platforms unlike std::hash
+static uint64_t hashSource(
+    const std::string &source,
+    uint64_t hash = 14695981039346656037ull)
+{
+    for (unsigned char c : source)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+ShaderCache::ShaderCache(
+    ShaderPreprocessor &preprocessor)
+    : _preprocessor(preprocessor)
+{}
+
+ShaderCache::~ShaderCache() = default;
+
+std::shared_ptr<Shader> ShaderCache::get(
+    const std::string &vertShaderStr,
+    const std::string &fragShaderStr,
+    const ShaderDefines &defines)
+{
+    // Included text is part of the key too, so the sources are preprocessed before the lookup
+    std::string vertSource, fragSource;
+
+    if (!_preprocessor.process(vertShaderStr, defines, vertSource) || !_preprocessor.process(fragShaderStr, defines, fragSource))
+    {
+        return nullptr;
+    }
+
+    // The separator keeps ("ab", "c") and ("a", "bc") apart
+    VariantKey key = {hashSource(fragSource, hashSource(vertSource + '\0')), defines};
+
+    auto found = _variants.find(key);
+
+    if (found != _variants.end())
+    {
+        return found->second;
+    }
+
+    auto shader = std::make_shared<Shader>();
+
+    if (!shader->compile(vertSource, fragSource))
+    {
+        return nullptr;
+    }
+
+    spdlog::debug("compiled shader variant {:016x} with {} defines", key.first, defines.size());
+
+    _variants.insert({key, shader});
+
+    return shader;
+}
+
+std::shared_ptr<ComputeShader> ShaderCache::getCompute(
+    const std::string &compShaderStr,
+    const ShaderDefines &defines)
+{
+    std::string compSource;
+
+    if (!_preprocessor.process(compShaderStr, defines, compSource))
+    {
+        return nullptr;
+    }
+
+    VariantKey key = {hashSource(compSource), defines};
+
+    auto found = _computeVariants.find(key);
+
+    if (found != _computeVariants.end())
+    {
+        return found->second;
+    }
+
+    auto shader = std::make_shared<ComputeShader>();
+
+    if (!shader->compile(compSource))
+    {
+        return nullptr;
+    }
+
+    spdlog::debug("compiled compute shader variant {:016x} with {} defines", key.first, defines.size());
+
+    _computeVariants.insert({key, shader});
+
+    return shader;
+}
+
+std::shared_ptr<Shader> ShaderCache::getStage(
+    GLenum stage,
+    const std::string &shaderStr,
+    const ShaderDefines &defines)
+{
+    std::string source;
+
+    if (!_preprocessor.process(shaderStr, defines, source))
+    {
+        return nullptr;
+    }
+
+    std::pair<GLenum, VariantKey> key = {stage, {hashSource(source), defines}};
+
+    auto found = _stageVariants.find(key);
+
+    if (found != _stageVariants.end())
+    {
+        return found->second;
+    }
+
+    auto shader = std::make_shared<Shader>();
+
+    if (!shader->compileStage(stage, source))
+    {
+        return nullptr;
+    }
+
+    spdlog::debug("compiled separable shader variant {:016x} with {} defines", key.second.first, defines.size());
+
+    _stageVariants.insert({key, shader});
+
+    return shader;
+}
+
+std::shared_ptr<ProgramPipeline> ShaderCache::getPipeline(
+    const std::shared_ptr<Shader> &vertStage,
+    const std::shared_ptr<Shader> &fragStage)
+{
+    if (vertStage == nullptr || fragStage == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::pair<std::shared_ptr<Shader>, std::shared_ptr<Shader>> key = {vertStage, fragStage};
+
+    auto found = _pipelines.find(key);
+
+    if (found != _pipelines.end())
+    {
+        return found->second;
+    }
+
+    auto pipeline = std::make_shared<ProgramPipeline>();
+
+    if (!pipeline->setup(*vertStage, *fragStage))
+    {
+        return nullptr;
+    }
+
+    _pipelines.insert({key, pipeline});
+
+    return pipeline;
+}
+
+size_t ShaderCache::size() const
+{
+    return _variants.size() + _computeVariants.size() + _stageVariants.size();
+}
+
+size_t ShaderCache::pipelineCount() const
+{
+    return _pipelines.size();
+}
+
+void ShaderCache::clear()
+{
+    _variants.clear();
+    _computeVariants.clear();
+    _stageVariants.clear();
+    _pipelines.clear();
+}
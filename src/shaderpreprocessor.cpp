@@ -0,0 +1,283 @@
+#include <shaderpreprocessor.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <sstream>
+
+static const int maxIncludeDepth = 32;
+
+static bool readFile(
+    const std::string &path,
+    std::string &content)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    content = ss.str();
+
+    return true;
+}
+
+static bool startsWithDirective(
+    const std::string &line,
+    const char *directive,
+    std::string &rest)
+{
+    auto start = line.find_first_not_of(" \t");
+
+    if (start == std::string::npos || line[start] != '#')
+    {
+        return false;
+    }
+
+    start = line.find_first_not_of(" \t", start + 1);
+
+    if (start == std::string::npos || line.compare(start, std::strlen(directive), directive) != 0)
+    {
+        return false;
+    }
+
+    rest = line.substr(start + std::strlen(directive));
+
+    return true;
+}
+
+ShaderPreprocessor::ShaderPreprocessor() = default;
+
+ShaderPreprocessor::~ShaderPreprocessor() = default;
+
+void ShaderPreprocessor::addIncludePath(
+    const std::string &path)
+{
+    _includePaths.push_back(path);
+}
+
+void ShaderPreprocessor::addInclude(
+    const std::string &name,
+    const std::string &source)
+{
+    _includes[name] = source;
+}
+
+bool ShaderPreprocessor::process(
+    const std::string &source,
+    const ShaderDefines &defines,
+    std::string &result)
+{
+    return process(source, std::string(), defines, result, nullptr);
+}
+
+bool ShaderPreprocessor::processFile(
+    const std::string &path,
+    const ShaderDefines &defines,
+    std::string &result,
+    std::vector<std::string> *files)
+{
+    std::string source;
+
+    if (!readFile(path, source))
+    {
+        spdlog::error("failed to read shader file {}", path);
+
+        return false;
+    }
+
+    return process(source, std::filesystem::weakly_canonical(path).string(), defines, result, files);
+}
+
+bool ShaderPreprocessor::process(
+    const std::string &source,
+    const std::string &sourcePath,
+    const ShaderDefines &defines,
+    std::string &result,
+    std::vector<std::string> *files)
+{
+    result.clear();
+
+    // The defines have to go after #version, which must be the first directive in a shader
+    size_t bodyStart = 0;
+    int bodyLine = 1;
+    std::istringstream lines(source);
+    std::string line, rest;
+
+    for (int n = 1; std::getline(lines, line); n++)
+    {
+        if (startsWithDirective(line, "version", rest))
+        {
+            bodyStart = std::min(source.size(), static_cast<size_t>(lines.tellg()));
+            bodyLine = n + 1;
+
+            result += line;
+            result += "\n";
+
+            break;
+        }
+    }
+
+    for (auto &define : defines)
+    {
+        result += "#define " + define.first + " " + define.second + "\n";
+    }
+
+    result += "#line " + std::to_string(bodyLine) + " 0\n";
+
+    std::set<std::string> onceFiles;
+    std::vector<std::string> sourceFiles = {sourcePath};
+    auto sourceDir = sourcePath.empty() ? std::string() : std::filesystem::path(sourcePath).parent_path().string();
+
+    if (!expandIncludes(source.substr(bodyStart), sourceDir, 0, bodyLine, 0, onceFiles, sourceFiles, result))
+    {
+        return false;
+    }
+
+    for (size_t i = 1; i < sourceFiles.size(); i++)
+    {
+        spdlog::debug("shader source string {} is {}", i, sourceFiles[i]);
+    }
+
+    if (files != nullptr)
+    {
+        files->clear();
+
+        for (auto &file : sourceFiles)
+        {
+            if (!file.empty() && _includes.count(file) == 0)
+            {
+                files->push_back(file);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ShaderPreprocessor::expandIncludes(
+    const std::string &source,
+    const std::string &sourceDir,
+    int sourceIndex,
+    int firstLine,
+    int depth,
+    std::set<std::string> &onceFiles,
+    std::vector<std::string> &files,
+    std::string &result)
+{
+    if (depth > maxIncludeDepth)
+    {
+        spdlog::error("shader includes nested deeper than {} levels", maxIncludeDepth);
+
+        return false;
+    }
+
+    std::istringstream lines(source);
+    std::string line, rest;
+
+    for (int n = firstLine; std::getline(lines, line); n++)
+    {
+        if (startsWithDirective(line, "pragma", rest) && rest.find("once") != std::string::npos)
+        {
+            onceFiles.insert(files[sourceIndex]);
+            result += "\n";
+
+            continue;
+        }
+
+        if (!startsWithDirective(line, "include", rest))
+        {
+            result += line;
+            result += "\n";
+
+            continue;
+        }
+
+        auto open = rest.find_first_of("\"<");
+        auto close = open == std::string::npos ? open : rest.find_first_of(rest[open] == '"' ? "\"" : ">", open + 1);
+
+        if (close == std::string::npos)
+        {
+            spdlog::error("malformed #include on line {} of shader source string {}", n, sourceIndex);
+
+            return false;
+        }
+
+        auto name = rest.substr(open + 1, close - open - 1);
+        std::string includePath, includeSource;
+
+        if (!loadInclude(name, sourceDir, includePath, includeSource))
+        {
+            spdlog::error("failed to resolve #include \"{}\" on line {} of shader source string {}", name, n, sourceIndex);
+
+            return false;
+        }
+
+        if (onceFiles.count(includePath) != 0)
+        {
+            result += "\n";
+
+            continue;
+        }
+
+        int includeIndex = static_cast<int>(files.size());
+        files.push_back(includePath);
+
+        result += "#line 1 " + std::to_string(includeIndex) + "\n";
+
+        auto includeDir = std::filesystem::path(includePath).parent_path().string();
+
+        if (!expandIncludes(includeSource, includeDir, includeIndex, 1, depth + 1, onceFiles, files, result))
+        {
+            return false;
+        }
+
+        result += "#line " + std::to_string(n + 1) + " " + std::to_string(sourceIndex) + "\n";
+    }
+
+    return true;
+}
+
+bool ShaderPreprocessor::loadInclude(
+    const std::string &name,
+    const std::string &sourceDir,
+    std::string &path,
+    std::string &source)
+{
+    auto include = _includes.find(name);
+
+    if (include != _includes.end())
+    {
+        path = name;
+        source = include->second;
+
+        return true;
+    }
+
+    std::vector<std::string> dirs;
+
+    if (!sourceDir.empty())
+    {
+        dirs.push_back(sourceDir);
+    }
+
+    dirs.insert(dirs.end(), _includePaths.begin(), _includePaths.end());
+
+    for (auto &dir : dirs)
+    {
+        auto candidate = std::filesystem::path(dir) / name;
+
+        if (std::filesystem::exists(candidate) && readFile(candidate.string(), source))
+        {
+            path = std::filesystem::weakly_canonical(candidate).string();
+
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,14 @@
+#version 450
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec2 uv;
+
+// SPIR-V has no uniform names, the explicit locations are what setUniform looks them up by
+layout(location = 0) uniform mat4 u_proj;
+layout(location = 1) uniform mat4 u_view;
+layout(location = 2) uniform mat4 u_model;
+
+void main()
+{
+    gl_Position = u_proj * u_view * u_model * vec4(pos.x, pos.y, pos.z, 1.0);
+}
@@ -0,0 +1,421 @@
+#include <shaderwatcher.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <spdlog/fmt/ranges.h>
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Editors often save a file in several writes, wait until it has been quiet for this long
+static const int settleMilliseconds = 50;
+
+#ifndef __linux__
+static const int pollMilliseconds = 250;
+#endif
+
+ShaderWatcher::ShaderWatcher(
+    const ShaderPreprocessor &preprocessor)
+    : _preprocessor(preprocessor)
+{
+#ifdef __linux__
+    _wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+
+    _thread = std::thread(&ShaderWatcher::watchThread, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    _stop = true;
+
+    wakeThread();
+
+    _thread.join();
+
+#ifdef __linux__
+    close(_wakeFd);
+#endif
+}
+
+bool ShaderWatcher::watch(
+    Shader &shader,
+    const std::string &vertPath,
+    const std::string &fragPath,
+    const ShaderDefines &defines)
+{
+    return watch(shader, {0, {vertPath, fragPath}, defines, {}});
+}
+
+bool ShaderWatcher::watchStage(
+    Shader &shader,
+    GLenum stage,
+    const std::string &path,
+    const ShaderDefines &defines)
+{
+    return watch(shader, {stage, {path}, defines, {}});
+}
+
+bool ShaderWatcher::readSources(
+    const WatchedShader &watched,
+    std::vector<std::string> &sources,
+    std::set<std::string> &files)
+{
+    sources.resize(watched.paths.size());
+
+    for (size_t i = 0; i < watched.paths.size(); i++)
+    {
+        std::vector<std::string> sourceFiles;
+
+        if (!_preprocessor.processFile(watched.paths[i], watched.defines, sources[i], &sourceFiles))
+        {
+            return false;
+        }
+
+        files.insert(sourceFiles.begin(), sourceFiles.end());
+    }
+
+    return true;
+}
+
+bool ShaderWatcher::watch(
+    Shader &shader,
+    const WatchedShader &watched)
+{
+    std::vector<std::string> sources;
+    std::set<std::string> files;
+
+    if (!readSources(watched, sources, files))
+    {
+        return false;
+    }
+
+    // Keep watching when the first compile fails, so fixing the file brings the shader up
+    bool compiled = watched.stage != 0 ? shader.compileStage(watched.stage, sources[0]) : shader.compile(sources[0], sources[1]);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto &entry = _shaders[&shader];
+        entry = watched;
+        entry.files = files;
+    }
+
+    wakeThread();
+
+    return compiled;
+}
+
+void ShaderWatcher::unwatch(
+    Shader &shader)
+{
+    // _compiling is only touched by update(), on the thread that owns the GL context like this one
+    if (_compiling.erase(&shader) != 0)
+    {
+        shader.cancelReload();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _shaders.erase(&shader);
+    _reloaded.erase(&shader);
+}
+
+void ShaderWatcher::update()
+{
+    std::map<Shader *, ReloadedSource> reloaded;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        reloaded.swap(_reloaded);
+    }
+
+    for (auto &source : reloaded)
+    {
+        auto &sources = source.second.sources;
+
+        if (source.second.stage != 0)
+        {
+            source.first->beginReload(source.second.stage, sources[0]);
+        }
+        else
+        {
+            source.first->beginReload(sources[0], sources[1]);
+        }
+
+        _compiling.insert(source.first);
+    }
+
+    for (auto shader = _compiling.begin(); shader != _compiling.end();)
+    {
+        if ((*shader)->pollReload())
+        {
+            shader = _compiling.erase(shader);
+        }
+        else
+        {
+            ++shader;
+        }
+    }
+}
+
+void ShaderWatcher::wakeThread()
+{
+#ifdef __linux__
+    uint64_t one = 1;
+
+    if (write(_wakeFd, &one, sizeof(one)) != sizeof(one))
+    {
+        spdlog::warn("failed to wake shader watcher thread");
+    }
+#endif
+}
+
+void ShaderWatcher::reloadChangedFiles(
+    const std::set<std::string> &changedFiles)
+{
+    std::map<Shader *, WatchedShader> affected;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (auto &shader : _shaders)
+        {
+            for (auto &file : changedFiles)
+            {
+                if (shader.second.files.count(file) != 0)
+                {
+                    affected.insert(shader);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (auto &shader : affected)
+    {
+        ReloadedSource source = {shader.second.stage, {}};
+        std::set<std::string> files;
+
+        if (!readSources(shader.second, source.sources, files))
+        {
+            continue;
+        }
+
+        spdlog::info("reloading shader from {}", fmt::join(shader.second.paths, " and "));
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto watched = _shaders.find(shader.first);
+
+        if (watched == _shaders.end())
+        {
+            continue;
+        }
+
+        // Includes may have been added or removed
+        watched->second.files = files;
+
+        _reloaded[shader.first] = source;
+    }
+}
+
+#ifdef __linux__
+
+static void readInotifyEvents(
+    int inotifyFd,
+    const std::map<int, std::string> &watchDirs,
+    std::set<std::string> &changedFiles)
+{
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;)
+    {
+        auto length = read(inotifyFd, buffer, sizeof(buffer));
+
+        if (length <= 0)
+        {
+            return;
+        }
+
+        for (char *p = buffer; p < buffer + length;)
+        {
+            auto event = reinterpret_cast<inotify_event *>(p);
+            auto dir = watchDirs.find(event->wd);
+
+            if (event->len > 0 && dir != watchDirs.end())
+            {
+                changedFiles.insert((std::filesystem::path(dir->second) / event->name).string());
+            }
+
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void ShaderWatcher::watchThread()
+{
+    int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotifyFd < 0)
+    {
+        spdlog::error("failed to initialize inotify, shader hot reload is disabled");
+
+        return;
+    }
+
+    std::map<std::string, int> dirWatches;
+    std::map<int, std::string> watchDirs;
+
+    while (!_stop)
+    {
+        // Watch directories rather than files, editors often replace a file instead of writing to it
+        std::set<std::string> dirs;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            for (auto &shader : _shaders)
+            {
+                for (auto &file : shader.second.files)
+                {
+                    dirs.insert(std::filesystem::path(file).parent_path().string());
+                }
+            }
+        }
+
+        for (auto dir = dirWatches.begin(); dir != dirWatches.end();)
+        {
+            if (dirs.count(dir->first) == 0)
+            {
+                inotify_rm_watch(inotifyFd, dir->second);
+                watchDirs.erase(dir->second);
+                dir = dirWatches.erase(dir);
+            }
+            else
+            {
+                ++dir;
+            }
+        }
+
+        for (auto &dir : dirs)
+        {
+            if (dirWatches.count(dir) != 0)
+            {
+                continue;
+            }
+
+            int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+            if (wd < 0)
+            {
+                spdlog::warn("failed to watch shader directory {}", dir);
+
+                continue;
+            }
+
+            dirWatches[dir] = wd;
+            watchDirs[wd] = dir;
+        }
+
+        pollfd fds[2] = {
+            {inotifyFd, POLLIN, 0},
+            {_wakeFd, POLLIN, 0},
+        };
+
+        if (poll(fds, 2, -1) <= 0)
+        {
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t count;
+
+            if (read(_wakeFd, &count, sizeof(count)) != sizeof(count))
+            {
+                spdlog::warn("failed to read shader watcher wake event");
+            }
+        }
+
+        std::set<std::string> changedFiles;
+
+        if (fds[0].revents & POLLIN)
+        {
+            do
+            {
+                readInotifyEvents(inotifyFd, watchDirs, changedFiles);
+            } while (!_stop && poll(fds, 1, settleMilliseconds) > 0);
+        }
+
+        if (!changedFiles.empty())
+        {
+            reloadChangedFiles(changedFiles);
+        }
+    }
+
+    close(inotifyFd);
+}
+
+#else
+
+void ShaderWatcher::watchThread()
+{
+    std::map<std::string, std::filesystem::file_time_type> writeTimes;
+
+    while (!_stop)
+    {
+        std::set<std::string> files;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            for (auto &shader : _shaders)
+            {
+                files.insert(shader.second.files.begin(), shader.second.files.end());
+            }
+        }
+
+        std::set<std::string> changedFiles;
+
+        for (auto &file : files)
+        {
+            std::error_code error;
+            auto writeTime = std::filesystem::last_write_time(file, error);
+
+            if (error)
+            {
+                continue;
+            }
+
+            auto found = writeTimes.find(file);
+
+            if (found != writeTimes.end() && found->second != writeTime)
+            {
+                changedFiles.insert(file);
+            }
+
+            writeTimes[file] = writeTime;
+        }
+
+        if (!changedFiles.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(settleMilliseconds));
+
+            reloadChangedFiles(changedFiles);
+        }
+
+        for (int slept = 0; slept < pollMilliseconds && !_stop; slept += settleMilliseconds)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(settleMilliseconds));
+        }
+    }
+}
+
+#endif